@@ -6,19 +6,35 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <limits.h>
 #include <list>
 #include <numeric>
+#include <random>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <sstream>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "config_service.h"
+#include "config_table.h"
+#include "file_reader.h"
+#include "flat_hash_map.h"
+#include "lru_cache.h"
+#include "thread_pool.h"
+
 using namespace std;
 using namespace chrono;
 
@@ -163,6 +179,150 @@ namespace
         ListNode(int x, ListNode *next) : val(x), next(next) {}
     };
 
+    /**
+     * Arena that owns every ListNode of a batch. Nodes are carved out of fixed-size blocks, so
+     * allocating is a pointer bump and nodes of one list end up next to each other in memory.
+     * release() hands the whole batch back in O(1): no per-node delete, and the blocks are kept
+     * for the next batch. ListNode is trivially destructible, so no destructors are skipped.
+     *
+     * Note: nodes from a pool must not be passed to code that deletes nodes individually.
+     */
+    class ListNodePool
+    {
+    public:
+        explicit ListNodePool(size_t blockSize = 4096) : blockSize(blockSize == 0 ? 1 : blockSize), cursor(this->blockSize)
+        {
+        }
+
+        ListNode *create(int val, ListNode *next = nullptr)
+        {
+            ListNode *node;
+            if (freeList)
+            {
+                node = freeList;
+                freeList = freeList->next;
+                --freeCount;
+            }
+            else
+            {
+                if (cursor == blockSize)
+                {
+                    grow();
+                }
+                node = &current[cursor++];
+            }
+            node->val = val;
+            node->next = next;
+            return node;
+        }
+
+        // Return a single node of this pool for reuse by later create() calls.
+        void recycle(ListNode *node)
+        {
+            node->next = freeList;
+            freeList = node;
+            ++freeCount;
+        }
+
+        // Return a chain of count nodes linked from head to tail, in O(1).
+        void recycle(ListNode *head, ListNode *tail, size_t count)
+        {
+            if (!head)
+            {
+                return;
+            }
+            tail->next = freeList;
+            freeList = head;
+            freeCount += count;
+        }
+
+        // Invalidate every node of the batch at once. Memory is kept for reuse.
+        void release()
+        {
+            usedBlocks = 0;
+            cursor = blockSize;
+            current = nullptr;
+            freeList = nullptr;
+            freeCount = 0;
+        }
+
+        // Nodes handed out, and not recycled, since the last release.
+        size_t size() const
+        {
+            return (usedBlocks == 0 ? 0 : (usedBlocks - 1) * blockSize + cursor) - freeCount;
+        }
+
+        size_t capacity() const { return blocks.size() * blockSize; }
+
+    private:
+        void grow()
+        {
+            if (usedBlocks == blocks.size())
+            {
+                blocks.emplace_back(new ListNode[blockSize]);
+            }
+            current = blocks[usedBlocks++].get();
+            cursor = 0;
+        }
+
+        size_t blockSize;
+        size_t cursor;
+        size_t usedBlocks = 0;
+        size_t freeCount = 0;
+        ListNode *current = nullptr;
+        ListNode *freeList = nullptr;
+        vector<unique_ptr<ListNode[]>> blocks;
+    };
+
+    /**
+     * Set of int values to test list nodes against. A dense range is stored as a flat bitmap,
+     * so a lookup is a shift and a mask. Sparse or wide sets fall back to a hash set.
+     */
+    class ValueSet
+    {
+    public:
+        static constexpr int64_t kMaxBitmapRange = 1 << 16;
+
+        explicit ValueSet(const vector<int> &values)
+        {
+            if (values.empty())
+            {
+                return;
+            }
+            auto bounds = minmax_element(values.begin(), values.end());
+            minValue = *bounds.first;
+            const int64_t range = (int64_t)*bounds.second - minValue + 1;
+            if (range <= kMaxBitmapRange)
+            {
+                bitmap.assign((range + 63) / 64, 0);
+                for (int v : values)
+                {
+                    const uint64_t offset = (int64_t)v - minValue;
+                    bitmap[offset / 64] |= 1ull << (offset % 64);
+                }
+                return;
+            }
+            hashed.insert(values.begin(), values.end());
+        }
+
+        bool contains(int value) const
+        {
+            if (!bitmap.empty())
+            {
+                const uint64_t offset = (uint64_t)((int64_t)value - minValue);
+                return offset < bitmap.size() * 64 && (bitmap[offset / 64] >> (offset % 64) & 1);
+            }
+            return !hashed.empty() && hashed.count(value) > 0;
+        }
+
+        bool usesBitmap() const { return !bitmap.empty(); }
+
+    private:
+        int64_t minValue = 0;
+        vector<uint64_t> bitmap;
+        unordered_set<int> hashed;
+    };
+
     class Solution
     {
     public:
@@ -171,8 +331,33 @@ namespace
          * The digits are stored in reverse order, and each of their nodes contains a single
          *  digit. Add the two numbers and return the sum as a linked list.
          * You may assume the two numbers do not contain any leading zero, except the number 0 itself.
+         *
+         * Single pass: both lists are walked together, least significant digit first, and the carry
+         * is propagated as the result is written. O(max(n, m)) time, no intermediate strings.
+         */
+        ListNode *addTwoNumbers(const ListNode *l1, const ListNode *l2)
+        {
+            return addDigits(l1, l2, [](int digit)
+                             { return new ListNode(digit); });
+        }
+
+        // Same as above, with the result nodes allocated from pool.
+        ListNode *addTwoNumbers(const ListNode *l1, const ListNode *l2, ListNodePool &pool)
+        {
+            return addDigits(l1, l2, [&pool](int digit)
+                             { return pool.create(digit); });
+        }
+
+        /**
+         * You are given two non-empty linked lists representing two non-negative integers.
+         * The digits are stored in reverse order, and each of their nodes contains a single
+         *  digit. Add the two numbers and return the sum as a linked list.
+         * You may assume the two numbers do not contain any leading zero, except the number 0 itself.
+         *
+         * Original implementation that round-trips through strings. Kept as the benchmark baseline
+         * for addTwoNumbers.
          */
-        ListNode *addTwoNumbers(ListNode *l1, ListNode *l2)
+        ListNode *addTwoNumbersViaStrings(ListNode *l1, ListNode *l2)
         {
             ListNode *list = l1;
             string num1, num2;
@@ -263,17 +448,19 @@ namespace
         vector<T> twoSum(const vector<T> &nums, const T target)
         {
             vector<T> result = {-1, -1};
-            unordered_map<T, T> map;
+            FlatHashMap<T, T> map;
+            map.reserve(nums.size());
             for (T i = 0; i < nums.size(); ++i)
             {
                 const T &complement = target - nums[i];
-                if (map.find(complement) != map.end())
+                auto it = map.find(complement);
+                if (it != map.end())
                 {
                     result[0] = i;
-                    result[1] = map[complement];
+                    result[1] = it->second; // reuse the lookup instead of a second map[complement]
                     return result;
                 }
-                map[nums[i]] = i;
+                map.insert_or_assign(nums[i], i);
             }
             return result;
         }
@@ -316,6 +503,41 @@ namespace
             }
         }
 
+        /**
+         * Remove every node whose value is in targets, in a single pass over the list. Removed nodes
+         * go back to pool, which must be the pool the list was built from.
+         * Returns the number of nodes removed.
+         */
+        size_t removeNodesWithValues(ListNode *&list, const ValueSet &targets, ListNodePool &pool)
+        {
+            return unlinkNodes(list, targets, [&pool](ListNode *node)
+                               { pool.recycle(node); });
+        }
+
+        /**
+         * Unlink every node whose value is in targets and pass it to onRemove. Walking a pointer to
+         * the incoming link means the head needs no special case.
+         */
+        template <typename OnRemove>
+        static size_t unlinkNodes(ListNode *&list, const ValueSet &targets, OnRemove &&onRemove)
+        {
+            size_t removed = 0;
+            ListNode **link = &list;
+            while (*link)
+            {
+                ListNode *node = *link;
+                if (targets.contains(node->val))
+                {
+                    *link = node->next;
+                    onRemove(node);
+                    ++removed;
+                    continue;
+                }
+                link = &node->next;
+            }
+            return removed;
+        }
+
         static void printList(const ListNode *list)
         {
             auto temp = list;
@@ -326,6 +548,33 @@ namespace
             }
             cout << "" << endl;
         }
+
+    private:
+        template <typename NewNode>
+        static ListNode *addDigits(const ListNode *l1, const ListNode *l2, NewNode &&newNode)
+        {
+            ListNode head; // dummy head avoids special-casing the first node
+            ListNode *tail = &head;
+            int carry = 0;
+            while (l1 || l2 || carry)
+            {
+                int sum = carry;
+                if (l1)
+                {
+                    sum += l1->val;
+                    l1 = l1->next;
+                }
+                if (l2)
+                {
+                    sum += l2->val;
+                    l2 = l2->next;
+                }
+                carry = sum >= 10;
+                tail->next = newNode(carry ? sum - 10 : sum);
+                tail = tail->next;
+            }
+            return head.next;
+        }
     };
 
     ListNode *createList(const vector<int> &v)
@@ -346,6 +595,174 @@ namespace
         return firstNode;
     }
 
+    // Build a list whose nodes all come from pool. Nodes are laid out contiguously within a block.
+    ListNode *createList(const vector<int> &v, ListNodePool &pool)
+    {
+        ListNode head;
+        ListNode *tail = &head;
+        for (const auto &a : v)
+        {
+            tail->next = pool.create(a);
+            tail = tail->next;
+        }
+        return head.next;
+    }
+
+    /**
+     * Remove targets from many lists in parallel. Every chunk of lists collects its removed nodes
+     * into a private chain, and the chains are handed back to pool after the workers finish, so
+     * the pool itself is never shared between threads.
+     * Returns the total number of nodes removed.
+     */
+    size_t removeNodesWithValues(vector<ListNode *> &lists, const ValueSet &targets, ListNodePool &pool, ThreadPool &threads)
+    {
+        struct Chain
+        {
+            ListNode *head = nullptr;
+            ListNode *tail = nullptr;
+            size_t count = 0;
+        };
+        vector<Chain> chains(threads.chunks(lists.size()));
+        threads.parallelFor(lists.size(), [&](size_t begin, size_t end, size_t chunk)
+                            {
+            Chain &chain = chains[chunk];
+            for (size_t i = begin; i < end; ++i)
+            {
+                Solution::unlinkNodes(lists[i], targets, [&chain](ListNode *node)
+                                      {
+                    node->next = chain.head;
+                    chain.head = node;
+                    if (!chain.tail)
+                    {
+                        chain.tail = node;
+                    }
+                    ++chain.count; });
+            } });
+
+        size_t removed = 0;
+        for (const Chain &chain : chains)
+        {
+            pool.recycle(chain.head, chain.tail, chain.count);
+            removed += chain.count;
+        }
+        return removed;
+    }
+
+    void deleteList(ListNode *list)
+    {
+        while (list)
+        {
+            ListNode *next = list->next;
+            delete list;
+            list = next;
+        }
+    }
+
+    /**
+     * Non-negative integer stored as base 10^9 limbs, least significant limb first. Nine digits
+     * are added per step instead of one, and the limbs sit contiguously in memory instead of
+     * behind a pointer chase, so long numbers that are added repeatedly should stay packed.
+     */
+    struct PackedDecimal
+    {
+        static constexpr uint32_t kBase = 1000000000;
+        static constexpr int kDigitsPerLimb = 9;
+
+        vector<uint32_t> limbs;
+
+        // Pack a digit list, least significant digit first, as used by addTwoNumbers.
+        static PackedDecimal fromList(const ListNode *list)
+        {
+            static constexpr uint32_t powers[kDigitsPerLimb] = {1, 10, 100, 1000, 10000, 100000,
+                                                                 1000000, 10000000, 100000000};
+            PackedDecimal result;
+            int position = 0;
+            uint32_t limb = 0;
+            for (; list; list = list->next)
+            {
+                limb += list->val * powers[position];
+                if (++position == kDigitsPerLimb)
+                {
+                    result.limbs.push_back(limb);
+                    limb = 0;
+                    position = 0;
+                }
+            }
+            if (position > 0 || result.limbs.empty())
+            {
+                result.limbs.push_back(limb);
+            }
+            return result;
+        }
+
+        // Carry-propagating limb addition in place.
+        PackedDecimal &operator+=(const PackedDecimal &other)
+        {
+            if (limbs.size() < other.limbs.size())
+            {
+                limbs.resize(other.limbs.size(), 0);
+            }
+            uint32_t carry = 0;
+            size_t i = 0;
+            for (; i < other.limbs.size(); ++i)
+            {
+                uint32_t sum = limbs[i] + other.limbs[i] + carry; // < 2 * 10^9 + 1, fits in 32 bits
+                carry = sum >= kBase;
+                limbs[i] = carry ? sum - kBase : sum;
+            }
+            for (; carry && i < limbs.size(); ++i)
+            {
+                carry = ++limbs[i] == kBase;
+                if (carry)
+                {
+                    limbs[i] = 0;
+                }
+            }
+            if (carry)
+            {
+                limbs.push_back(1);
+            }
+            return *this;
+        }
+
+        // Unpack into a digit list without leading zeros, least significant digit first.
+        ListNode *toList() const
+        {
+            ListNode head;
+            ListNode *tail = &head;
+            for (size_t i = 0; i < limbs.size(); ++i)
+            {
+                uint32_t limb = limbs[i];
+                const bool last = i + 1 == limbs.size();
+                for (int d = 0; d < kDigitsPerLimb && (!last || limb > 0 || d == 0); ++d)
+                {
+                    tail->next = new ListNode(limb % 10);
+                    tail = tail->next;
+                    limb /= 10;
+                }
+            }
+            return head.next;
+        }
+    };
+
+    // Add two digit lists through packed limbs. Pays for packing and unpacking, see PackedDecimal.
+    ListNode *addTwoNumbersPacked(const ListNode *l1, const ListNode *l2)
+    {
+        PackedDecimal sum = PackedDecimal::fromList(l1);
+        sum += PackedDecimal::fromList(l2);
+        return sum.toList();
+    }
+
+    vector<int> toVector(const ListNode *list)
+    {
+        vector<int> digits;
+        for (; list; list = list->next)
+        {
+            digits.push_back(list->val);
+        }
+        return digits;
+    }
+
     TEST(AlgorithmTest, TwoSum)
     {
         vector<int> input = {3, 2, 4};
@@ -376,11 +793,12 @@ namespace
         vector<int> v1 = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
         vector<int> v2 = {5, 6, 4};
         vector<int> expected = {6, 6, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
-        ListNode *ln1Ptr = createList(v1);
-        ListNode *ln2Ptr = createList(v2);
+        ListNodePool pool; // owns every node below, freed when the test ends
+        ListNode *ln1Ptr = createList(v1, pool);
+        ListNode *ln2Ptr = createList(v2, pool);
         Solution sol;
         auto start = high_resolution_clock::now();
-        ListNode *res = sol.addTwoNumbers(ln1Ptr, ln2Ptr);
+        ListNode *res = sol.addTwoNumbers(ln1Ptr, ln2Ptr, pool);
         auto stop = high_resolution_clock::now();
         auto duration = duration_cast<microseconds>(stop - start);
         cout << "Run time: " << duration.count() << "us" << endl;
@@ -391,6 +809,147 @@ namespace
         }
     }
 
+    TEST(AlgorithmTest, ListNodePoolBatches)
+    {
+        ListNodePool pool(4);
+        ListNode *list = createList({1, 2, 3, 4, 5, 6}, pool); // spans two blocks
+        EXPECT_EQ(toVector(list), vector<int>({1, 2, 3, 4, 5, 6}));
+        EXPECT_EQ(pool.size(), 6);
+        EXPECT_EQ(pool.capacity(), 8);
+
+        Solution sol;
+        ListNode *sum = sol.addTwoNumbers(createList({9, 9}, pool), createList({1}, pool), pool);
+        EXPECT_EQ(toVector(sum), vector<int>({0, 0, 1}));
+
+        // Releasing the batch keeps the blocks, so the next batch allocates nothing new
+        const size_t capacity = pool.capacity();
+        pool.release();
+        EXPECT_EQ(pool.size(), 0);
+        list = createList({7, 8, 9}, pool);
+        EXPECT_EQ(toVector(list), vector<int>({7, 8, 9}));
+        EXPECT_EQ(pool.capacity(), capacity);
+    }
+
+    // Benchmark: build and tear down many short lists, per-node new/delete vs one pool per batch.
+    TEST(AlgorithmTest, ListNodePoolBenchmark)
+    {
+        const int lists = 200000;
+        const vector<int> digits = {1, 2, 3, 4, 5, 6, 7, 8};
+        long long checksum = 0;
+
+        auto start = high_resolution_clock::now();
+        for (int i = 0; i < lists; ++i)
+        {
+            ListNode *list = createList(digits);
+            checksum += list->val;
+            deleteList(list);
+        }
+        auto heapUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+        ListNodePool pool;
+        start = high_resolution_clock::now();
+        for (int batch = 0; batch < 10; ++batch)
+        {
+            for (int i = 0; i < lists / 10; ++i)
+            {
+                checksum += createList(digits, pool)->val;
+            }
+            pool.release(); // whole batch in O(1)
+        }
+        auto poolUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+        EXPECT_EQ(checksum, 2 * lists);
+        cout << "Run time (" << lists << " lists of " << digits.size() << "): new/delete " << heapUs
+             << "us, pool " << poolUs << "us" << endl;
+    }
+
+    TEST(AlgorithmTest, AddTwoNumbersMatchesStringVersion)
+    {
+        Solution sol;
+        mt19937 engine(11);
+        vector<pair<vector<int>, vector<int>>> cases = {
+            {{0}, {0}},
+            {{9, 9, 9}, {1}},
+            {{9, 9, 9, 9, 9, 9, 9, 9, 9}, {1}}, // carry out of a full limb
+            {{5}, {5}},
+        };
+        for (int length : {1, 8, 9, 10, 17, 18, 19, 100, 1000})
+        {
+            vector<int> a(length), b(1 + engine() % length);
+            generate(a.begin(), a.end(), [&]
+                     { return (int)(engine() % 10); });
+            generate(b.begin(), b.end(), [&]
+                     { return (int)(engine() % 10); });
+            a.back() = 1 + engine() % 9;
+            b.back() = 1 + engine() % 9;
+            cases.emplace_back(a, b);
+        }
+        for (const auto &c : cases)
+        {
+            ListNode *l1 = createList(c.first);
+            ListNode *l2 = createList(c.second);
+            ListNode *expected = sol.addTwoNumbersViaStrings(l1, l2);
+            ListNode *single = sol.addTwoNumbers(l1, l2);
+            ListNode *packed = addTwoNumbersPacked(l1, l2);
+            EXPECT_EQ(toVector(single), toVector(expected));
+            EXPECT_EQ(toVector(packed), toVector(expected));
+            for (ListNode *list : {l1, l2, expected, single, packed})
+            {
+                deleteList(list);
+            }
+        }
+    }
+
+    // Benchmark: million-digit addition, string round-trip vs single pass vs packed limbs.
+    TEST(AlgorithmTest, AddTwoNumbersMillionDigitBenchmark)
+    {
+        const int digits = 1000000;
+        vector<int> a(digits), b(digits);
+        mt19937 engine(5);
+        generate(a.begin(), a.end(), [&]
+                 { return (int)(engine() % 10); });
+        generate(b.begin(), b.end(), [&]
+                 { return (int)(engine() % 10); });
+        a.back() = 9;
+        b.back() = 9;
+        ListNode *l1 = createList(a);
+        ListNode *l2 = createList(b);
+        Solution sol;
+
+        auto time = [](auto &&fn)
+        {
+            auto start = high_resolution_clock::now();
+            fn();
+            return duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        };
+        ListNode *viaStrings = nullptr, *singlePass = nullptr;
+        auto stringsUs = time([&]
+                              { viaStrings = sol.addTwoNumbersViaStrings(l1, l2); });
+        auto singlePassUs = time([&]
+                                 { singlePass = sol.addTwoNumbers(l1, l2); });
+        // Like the two above, this includes building the result list (and packing the inputs)
+        ListNode *packed = nullptr;
+        auto packedUs = time([&]
+                             { packed = addTwoNumbersPacked(l1, l2); });
+        // The limb addition alone, for inputs that already live in packed form
+        PackedDecimal p1 = PackedDecimal::fromList(l1);
+        PackedDecimal p2 = PackedDecimal::fromList(l2);
+        auto limbAddUs = time([&]
+                              { p1 += p2; });
+        ListNode *limbSum = p1.toList();
+
+        EXPECT_EQ(toVector(singlePass), toVector(viaStrings));
+        EXPECT_EQ(toVector(packed), toVector(viaStrings));
+        EXPECT_EQ(toVector(limbSum), toVector(viaStrings));
+        cout << "Run time (" << digits << " digits): strings " << stringsUs << "us, single pass "
+             << singlePassUs << "us, packed limbs incl. packing " << packedUs << "us (limb addition alone "
+             << limbAddUs << "us)" << endl;
+        for (ListNode *list : {l1, l2, viaStrings, singlePass, packed, limbSum})
+        {
+            deleteList(list);
+        }
+    }
+
     TEST(AlgorithmTest, RemoveNodesWithValue)
     {
         vector<int> v = {1, 3, 4, 3, 1, 1, 4, 5, 6, 7, 1};
@@ -428,88 +987,794 @@ namespace
         }
     }
 
-    class LRUCache
+    TEST(AlgorithmTest, RemoveNodesWithValues)
     {
+        ListNodePool pool;
+        Solution sol;
+        ListNode *list = createList({1, 3, 4, 3, 1, 1, 4, 5, 6, 7, 1}, pool);
+        EXPECT_EQ(sol.removeNodesWithValues(list, ValueSet({1, 4}), pool), 6);
+        EXPECT_EQ(toVector(list), vector<int>({3, 3, 5, 6, 7}));
+
+        list = createList({2, 2, 2}, pool);
+        sol.removeNodesWithValues(list, ValueSet({2}), pool);
+        EXPECT_EQ(list, nullptr);
+
+        // Wide ranges fall back to hashing, negative values work in both modes
+        ValueSet wide({-5, 1000000000});
+        EXPECT_FALSE(wide.usesBitmap());
+        ValueSet dense({-5, 3, 100});
+        EXPECT_TRUE(dense.usesBitmap());
+        EXPECT_FALSE(dense.contains(-6));
+        EXPECT_FALSE(dense.contains(INT_MAX));
+        EXPECT_FALSE(ValueSet({}).contains(0));
+        list = createList({-5, 0, 1000000000, 3, -5}, pool);
+        sol.removeNodesWithValues(list, wide, pool);
+        EXPECT_EQ(toVector(list), vector<int>({0, 3}));
+
+        // Removed nodes are reused before new memory is carved out
+        const size_t capacity = pool.capacity();
+        const size_t live = pool.size();
+        createList(vector<int>(12, 0), pool);
+        EXPECT_EQ(pool.capacity(), capacity);
+        EXPECT_EQ(pool.size(), live + 12);
+    }
 
-    public:
-        LRUCache(int capacity) : capacity(capacity)
+    TEST(AlgorithmTest, RemoveNodesWithValuesParallel)
+    {
+        ListNodePool pool;
+        ThreadPool threads(4);
+        mt19937 engine(9);
+        vector<vector<int>> values(500);
+        vector<ListNode *> lists;
+        for (auto &v : values)
+        {
+            v.resize(engine() % 20);
+            generate(v.begin(), v.end(), [&]
+                     { return (int)(engine() % 16); });
+            lists.push_back(createList(v, pool));
+        }
+        const vector<int> targets = {0, 3, 7, 15};
+        size_t expectedRemoved = 0;
+        for (auto &v : values)
         {
+            auto end = remove_if(v.begin(), v.end(), [&](int x)
+                                 { return find(targets.begin(), targets.end(), x) != targets.end(); });
+            expectedRemoved += v.end() - end;
+            v.erase(end, v.end());
         }
 
-        // Get value given key
-        string get(int key)
+        const size_t live = pool.size();
+        EXPECT_EQ(removeNodesWithValues(lists, ValueSet(targets), pool, threads), expectedRemoved);
+        EXPECT_EQ(pool.size(), live - expectedRemoved);
+        for (size_t i = 0; i < lists.size(); ++i)
         {
-            // Keep track of stored keys in a map to ensure O(1) access time complexity
-            auto it = map.find(key);
-            if (it == map.end())
+            EXPECT_EQ(toVector(lists[i]), values[i]);
+        }
+    }
+
+    // A throwing chunk must not let parallelFor return while other chunks still use its arguments
+    TEST(AlgorithmTest, ThreadPoolParallelForException)
+    {
+        ThreadPool threads(4);
+        atomic<int> finished{0};
+        EXPECT_THROW(threads.parallelFor(4, [&](size_t, size_t, size_t chunk)
+                                         {
+            if (chunk == 0)
             {
-                return "not found"; // not found
+                throw runtime_error("chunk failed");
             }
-            // Update the cache since the key has been found. Need to update front to most recently used.
-            cache.splice(cache.begin(), cache, it->second);
-            return it->second->second;
+            this_thread::sleep_for(chrono::milliseconds(20));
+            ++finished; }),
+                     runtime_error);
+        EXPECT_EQ(finished.load(), 3);
+    }
+
+    // Benchmark: remove 8 target values from many lists, one pass per value vs one pass total.
+    TEST(AlgorithmTest, RemoveNodesWithValuesBenchmark)
+    {
+        const int listCount = 20000;
+        const vector<int> targets = {1, 5, 9, 13, 17, 21, 25, 29};
+        mt19937 engine(4);
+        vector<vector<int>> values(listCount, vector<int>(32));
+        for (auto &v : values)
+        {
+            generate(v.begin(), v.end(), [&]
+                     { return (int)(engine() % 32); });
         }
+        Solution sol;
+        size_t remaining = 0;
 
-        // Put key and value into least recently used cache
-        void put(int key, string value)
+        vector<ListNode *> heapLists;
+        for (const auto &v : values)
+        {
+            heapLists.push_back(createList(v));
+        }
+        auto start = high_resolution_clock::now();
+        for (auto &list : heapLists)
         {
-            auto it = map.find(key);
-            if (it != map.end())
+            for (int target : targets)
             {
-                // Found it in the map. Update value and splice accordingly.
-                it->second->second = value;
-                cache.splice(cache.begin(), cache, it->second);
-                return;
+                sol.removeNodesWithValue(list, target);
             }
+        }
+        auto perValueUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        for (ListNode *list : heapLists)
+        {
+            remaining += toVector(list).size();
+            deleteList(list);
+        }
 
-            if (cache.size() == capacity)
-            {
-                // Sync and update the map accordingly, since we will be adding to the map afterwards
-                // erase the k/v pair from map given oldest item in cache using its key
-                map.erase(cache.back().first);
-                cache.pop_back();
-            }
+        ListNodePool pool;
+        const ValueSet targetSet(targets);
+        vector<ListNode *> pooled;
+        for (const auto &v : values)
+        {
+            pooled.push_back(createList(v, pool));
+        }
+        start = high_resolution_clock::now();
+        for (auto &list : pooled)
+        {
+            sol.removeNodesWithValues(list, targetSet, pool);
+        }
+        auto onePassUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
 
-            // Did not find it in the map. Must store in cache and map.
-            cache.emplace_front(key, value);
-            map[key] = cache.begin();
+        pool.release();
+        pooled.clear();
+        for (const auto &v : values)
+        {
+            pooled.push_back(createList(v, pool));
+        }
+        ThreadPool threads;
+        start = high_resolution_clock::now();
+        removeNodesWithValues(pooled, targetSet, pool, threads);
+        auto parallelUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        size_t pooledRemaining = 0;
+        for (ListNode *list : pooled)
+        {
+            pooledRemaining += toVector(list).size();
         }
 
-    private:
-        int capacity;
-        list<pair<int, string>> cache;
-        // Stores the beginning iterator of the cache, which holds the most recently used item that
-        // was pushed.
-        unordered_map<int, list<pair<int, string>>::iterator> map;
-    };
+        EXPECT_EQ(pooledRemaining, remaining);
+        cout << "Run time (" << listCount << " lists, " << targets.size() << " targets): per value "
+             << perValueUs << "us, one pass " << onePassUs << "us, parallel (" << threads.size()
+             << " threads) " << parallelUs << "us" << endl;
+    }
 
     TEST(AlgorithmTest, LRUCachePutGet)
     {
-        LRUCache cache(2);
+        LRUCache<int, string> cache(2);
 
         cache.put(1, "one");
         cache.put(2, "two");
-        std::cout << cache.get(1) << std::endl; // returns 1
-        assert(cache.get(1) == "one");
-        cache.put(3, "three");                  // evicts key 2
-        std::cout << cache.get(2) << std::endl; // returns not found
-        assert(cache.get(2) == "not found");
-        std::cout << cache.get(3) << std::endl; // returns 3
-        assert(cache.get(3) == "three");
-        cache.put(4, "four");                   // evicts key 1
-        std::cout << cache.get(1) << std::endl; // returns not found
-        assert(cache.get(1) == "not found");
-        std::cout << cache.get(3) << std::endl; // returns 3
-        assert(cache.get(3) == "three");
-        std::cout << cache.get(4) << std::endl; // returns 4
-        assert(cache.get(4) == "four");
+        std::cout << *cache.get(1) << std::endl; // returns 1
+        assert(*cache.get(1) == "one");
+        cache.put(3, "three");                   // evicts key 2
+        assert(cache.get(2) == nullptr);         // not found
+        std::cout << *cache.get(3) << std::endl; // returns 3
+        assert(*cache.get(3) == "three");
+        cache.put(4, "four");                    // evicts key 1
+        assert(cache.get(1) == nullptr);         // not found
+        std::cout << *cache.get(3) << std::endl; // returns 3
+        assert(*cache.get(3) == "three");
+        std::cout << *cache.get(4) << std::endl; // returns 4
+        assert(*cache.get(4) == "four");
     }
 
-    // Write algorithm to return the value of last man standing in circle of people
-    // where there are N people and mth is the person out.
-    int lastManStanding(int N, int m)
+    TEST(AlgorithmTest, LRUCacheStringKeys)
     {
-        if (m < 1 || N < 1)
+        LRUCache<string, string> cache(2);
+        string key = "alpha";
+        cache.put(key, string(1024, 'a'));      // key copied, value moved
+        cache.emplace(string("beta"), 1024, 'b'); // value constructed in place
+
+        // Heterogeneous lookup: no std::string temporary is created for the key
+        string_view view = "alpha";
+        ASSERT_NE(cache.get(view), nullptr);
+        EXPECT_EQ(cache.get("beta")->size(), 1024);
+        EXPECT_EQ(cache.get("gamma"), nullptr);
+
+        // get() hands out the stored value, so writes through it are visible to later lookups
+        string *value = cache.get("alpha");
+        value->assign("updated");
+        EXPECT_EQ(*cache.peek("alpha"), "updated");
+
+        cache.put("gamma", "three"); // evicts beta, alpha was used last
+        EXPECT_EQ(cache.peek("beta"), nullptr);
+        EXPECT_EQ(*cache.get("alpha"), "updated");
+        EXPECT_EQ(cache.size(), 2);
+    }
+
+    TEST(AlgorithmTest, LRUCacheMoveOnlyValues)
+    {
+        LRUCache<int, unique_ptr<string>> cache(1);
+        cache.put(1, make_unique<string>("one"));
+        ASSERT_NE(cache.get(1), nullptr);
+        EXPECT_EQ(**cache.get(1), "one");
+        cache.emplace(2, new string("two")); // evicts key 1
+        EXPECT_EQ(cache.get(1), nullptr);
+        EXPECT_EQ(**cache.get(2), "two");
+    }
+
+    TEST(AlgorithmTest, ShardedLRUCachePutGet)
+    {
+        // A single shard behaves exactly like LRUCache
+        ShardedLRUCache<int, string> cache(2, 1);
+        cache.put(1, "one");
+        cache.put(2, "two");
+        EXPECT_EQ(cache.get(1), "one");
+        cache.put(3, "three"); // evicts key 2
+        EXPECT_EQ(cache.get(2), nullopt);
+        EXPECT_EQ(cache.get(3), "three");
+        EXPECT_EQ(cache.shardCount(), 1);
+
+        // Shard count is rounded up to a power of two, capacity is split across shards
+        ShardedLRUCache<int, string> sharded(100, 6);
+        EXPECT_EQ(sharded.shardCount(), 8);
+        for (int i = 0; i < 1000; ++i)
+        {
+            sharded.put(i, to_string(i));
+        }
+        EXPECT_LE(sharded.size(), 8 * 13);
+        EXPECT_EQ(sharded.get(999), "999");
+    }
+
+    TEST(AlgorithmTest, ShardedLRUCacheBufferedReads)
+    {
+        using Cache = ShardedLRUCache<int, string>;
+        Cache cache(Cache::kReadBatchSize, 1, true);
+        for (int i = 0; i < (int)Cache::kReadBatchSize; ++i)
+        {
+            cache.put(i, to_string(i));
+        }
+        // Key 0 is the least recently used entry. Reading it records a hint that is applied by
+        // the next put, so the put evicts key 1 instead.
+        EXPECT_EQ(cache.get(0), "0");
+        cache.put(100, "100");
+        EXPECT_EQ(cache.get(0), "0");
+        EXPECT_EQ(cache.get(1), nullopt);
+        EXPECT_EQ(cache.size(), Cache::kReadBatchSize);
+    }
+
+    TEST(AlgorithmTest, ShardedLRUCacheConcurrentAccess)
+    {
+        ShardedLRUCache<string, string> cache(256, 16, true);
+        vector<thread> threads;
+        atomic<int> mismatches{0};
+        for (int t = 0; t < 8; ++t)
+        {
+            threads.emplace_back([&cache, &mismatches, t]
+                                 {
+                for (int i = 0; i < 2000; ++i)
+                {
+                    const string key = to_string((i * 7 + t) % 512);
+                    if (i % 4 == 0)
+                    {
+                        cache.put(key, "value-" + key);
+                        continue;
+                    }
+                    const auto value = cache.get(key);
+                    if (value && *value != "value-" + key)
+                    {
+                        mismatches++;
+                    }
+                } });
+        }
+        for (auto &th : threads)
+        {
+            th.join();
+        }
+        EXPECT_EQ(mismatches, 0);
+        EXPECT_LE(cache.size(), 256);
+    }
+
+    /**
+     * Zipfian key generator. Key k in [0, n) is drawn with probability proportional to 1 / (k + 1)^s,
+     * so a handful of hot keys receive most of the traffic, as in real request streams.
+     */
+    class ZipfGenerator
+    {
+    public:
+        ZipfGenerator(int n, double s, unsigned seed) : cdf(n), engine(seed), uniform(0.0, 1.0)
+        {
+            double sum = 0;
+            for (int k = 0; k < n; ++k)
+            {
+                sum += 1.0 / pow(k + 1, s);
+                cdf[k] = sum;
+            }
+            for (auto &c : cdf)
+            {
+                c /= sum;
+            }
+        }
+
+        int next()
+        {
+            auto it = lower_bound(cdf.begin(), cdf.end(), uniform(engine));
+            return it == cdf.end() ? (int)cdf.size() - 1 : (int)(it - cdf.begin());
+        }
+
+    private:
+        vector<double> cdf;
+        mt19937 engine;
+        uniform_real_distribution<double> uniform;
+    };
+
+    // Benchmark: 90% reads / 10% writes on Zipfian keys, 1 to 64 threads, global lock vs shards.
+    TEST(AlgorithmTest, ShardedLRUCacheZipfBenchmark)
+    {
+        const int keySpace = 10000;
+        const int capacity = 1000;
+        const int totalOps = 32000;
+
+        auto run = [&](int threadCount, auto &&get, auto &&put)
+        {
+            vector<vector<int>> keys(threadCount);
+            for (int t = 0; t < threadCount; ++t)
+            {
+                ZipfGenerator zipf(keySpace, 0.99, t + 1);
+                for (int i = 0; i < totalOps / threadCount; ++i)
+                {
+                    keys[t].push_back(zipf.next());
+                }
+            }
+            auto start = high_resolution_clock::now();
+            vector<thread> threads;
+            for (int t = 0; t < threadCount; ++t)
+            {
+                threads.emplace_back([&, t]
+                                     {
+                    for (size_t i = 0; i < keys[t].size(); ++i)
+                    {
+                        const int key = keys[t][i];
+                        if (i % 10 == 0 || !get(key))
+                        {
+                            put(key, "value");
+                        }
+                    } });
+            }
+            for (auto &th : threads)
+            {
+                th.join();
+            }
+            auto elapsed = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+            return elapsed == 0 ? 0.0 : totalOps * 1e6 / elapsed;
+        };
+
+        for (int threadCount = 1; threadCount <= 64; threadCount *= 2)
+        {
+            LRUCache<int, string> global(capacity);
+            mutex globalMutex;
+            ShardedLRUCache<int, string> sharded(capacity, 16);
+            ShardedLRUCache<int, string> buffered(capacity, 16, true);
+
+            double globalOps = run(
+                threadCount,
+                [&](int k)
+                { lock_guard<mutex> lock(globalMutex); return global.get(k) != nullptr; },
+                [&](int k, const string &v)
+                { lock_guard<mutex> lock(globalMutex); global.put(k, v); });
+            double shardedOps = run(
+                threadCount, [&](int k)
+                { return sharded.get(k).has_value(); },
+                [&](int k, const string &v)
+                { sharded.put(k, v); });
+            double bufferedOps = run(
+                threadCount, [&](int k)
+                { return buffered.get(k).has_value(); },
+                [&](int k, const string &v)
+                { buffered.put(k, v); });
+
+            cout << "threads: " << threadCount << ", global lock: " << (long)globalOps
+                 << " ops/s, sharded: " << (long)shardedOps << " ops/s, sharded+buffered reads: "
+                 << (long)bufferedOps << " ops/s" << endl;
+        }
+    }
+
+    template <template <typename, typename> class Policy>
+    void checkPolicyBasics()
+    {
+        PolicyCache<int, string, Policy> cache(4);
+        for (int i = 0; i < 100; ++i)
+        {
+            cache.put(i, to_string(i));
+            ASSERT_LE(cache.size(), 4);
+        }
+        // A resident key is always readable and overwriting it keeps the size stable
+        cache.put(1000, "x");
+        cache.put(1000, "y");
+        string *value = cache.get(1000);
+        if (value) // admission control may have rejected a brand new key
+        {
+            EXPECT_EQ(*value, "y");
+        }
+        EXPECT_LE(cache.size(), 4);
+        EXPECT_TRUE(cache.erase(1000) || value == nullptr);
+        EXPECT_EQ(cache.get(1000), nullptr);
+    }
+
+    TEST(AlgorithmTest, PolicyCacheBasics)
+    {
+        checkPolicyBasics<LRUPolicy>();
+        checkPolicyBasics<ClockPolicy>();
+        checkPolicyBasics<TwoQueuePolicy>();
+        checkPolicyBasics<ARCPolicy>();
+        checkPolicyBasics<WTinyLFUPolicy>();
+
+        // The LRU policy matches LRUCache
+        PolicyCache<int, string> lru(2);
+        lru.put(1, "one");
+        lru.put(2, "two");
+        EXPECT_EQ(*lru.get(1), "one");
+        lru.put(3, "three"); // evicts key 2
+        EXPECT_EQ(lru.get(2), nullptr);
+        EXPECT_EQ(*lru.get(3), "three");
+        EXPECT_EQ(lru.hits(), 2);
+        EXPECT_EQ(lru.misses(), 1);
+        EXPECT_EQ(lru.evictions(), 1);
+    }
+
+    // Replay a key trace through a cache: read, and insert on a miss. Returns the hit ratio.
+    template <template <typename, typename> class Policy>
+    double replayTrace(const vector<int> &trace, size_t capacity, double &opsPerSecond)
+    {
+        PolicyCache<int, int, Policy> cache(capacity);
+        auto start = high_resolution_clock::now();
+        for (int key : trace)
+        {
+            if (!cache.get(key))
+            {
+                cache.put(key, key);
+            }
+        }
+        auto elapsed = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        opsPerSecond = elapsed == 0 ? 0.0 : trace.size() * 1e6 / elapsed;
+        return cache.hitRatio();
+    }
+
+    TEST(AlgorithmTest, PolicyCacheScanResistance)
+    {
+        // Hot keys mixed with one-off cold keys, then a long one-off scan
+        vector<int> warmup;
+        int coldKey = 1000;
+        for (int round = 0; round < 20; ++round)
+        {
+            for (int k = 0; k < 50; ++k)
+            {
+                warmup.push_back(k);
+                warmup.push_back(coldKey++);
+            }
+        }
+        for (int k = 0; k < 2000; ++k)
+        {
+            warmup.push_back(coldKey++);
+        }
+
+        // Count how many hot keys survived the scan
+        auto hotHitsAfterScan = [&](auto &&cache)
+        {
+            for (int key : warmup)
+            {
+                if (!cache.get(key))
+                {
+                    cache.put(key, key);
+                }
+            }
+            size_t hits = 0;
+            for (int k = 0; k < 50; ++k)
+            {
+                hits += cache.get(k) != nullptr;
+            }
+            return hits;
+        };
+        EXPECT_EQ(hotHitsAfterScan(PolicyCache<int, int, LRUPolicy>(100)), 0);
+        EXPECT_GT(hotHitsAfterScan(PolicyCache<int, int, TwoQueuePolicy>(100)), 25);
+        EXPECT_GT(hotHitsAfterScan(PolicyCache<int, int, ARCPolicy>(100)), 25);
+        EXPECT_GT(hotHitsAfterScan(PolicyCache<int, int, WTinyLFUPolicy>(100)), 25);
+    }
+
+    // Read a recorded trace with one integer key per line.
+    vector<int> loadTrace(const string &path)
+    {
+        vector<int> trace;
+        ifstream file(path);
+        int key;
+        while (file >> key)
+        {
+            trace.push_back(key);
+        }
+        return trace;
+    }
+
+    // Benchmark: hit ratio and ops/sec per policy. Replays the trace named by CACHE_TRACE if set,
+    // otherwise a Zipfian workload polluted by periodic one-off scans.
+    TEST(AlgorithmTest, PolicyCacheTraceReplayBenchmark)
+    {
+        vector<int> trace;
+        const char *tracePath = getenv("CACHE_TRACE");
+        if (tracePath)
+        {
+            trace = loadTrace(tracePath);
+        }
+        if (trace.empty())
+        {
+            ZipfGenerator zipf(5000, 0.9, 42);
+            int scanKey = 1000000;
+            for (int i = 0; i < 100000; ++i)
+            {
+                trace.push_back(i % 5000 < 1000 ? scanKey++ : zipf.next());
+            }
+        }
+
+        const size_t capacity = 500;
+        auto report = [&](const char *name, double hitRatio, double opsPerSecond)
+        {
+            cout << name << ": hit ratio " << hitRatio << ", " << (long)opsPerSecond << " ops/s" << endl;
+        };
+        double ops;
+        double lru = replayTrace<LRUPolicy>(trace, capacity, ops);
+        report("LRU", lru, ops);
+        double clock = replayTrace<ClockPolicy>(trace, capacity, ops);
+        report("CLOCK", clock, ops);
+        double twoQueue = replayTrace<TwoQueuePolicy>(trace, capacity, ops);
+        report("2Q", twoQueue, ops);
+        double arc = replayTrace<ARCPolicy>(trace, capacity, ops);
+        report("ARC", arc, ops);
+        double tinyLfu = replayTrace<WTinyLFUPolicy>(trace, capacity, ops);
+        report("W-TinyLFU", tinyLfu, ops);
+        if (!tracePath)
+        {
+            EXPECT_GT(tinyLfu, lru);
+        }
+    }
+
+    // Clock that only moves when a test says so
+    struct ManualClock
+    {
+        using time_point = steady_clock::time_point;
+        static time_point now() { return current; }
+        static void advance(milliseconds step) { current += step; }
+        static inline time_point current{};
+    };
+
+    TEST(AlgorithmTest, TimingWheelFiresOnTime)
+    {
+        using Wheel = HierarchicalTimingWheel<uint64_t>;
+        Wheel wheel;
+        mt19937 engine(7);
+        vector<Wheel::Handle> handles(2000);
+        vector<uint64_t> expiries(handles.size());
+        for (size_t i = 0; i < handles.size(); ++i)
+        {
+            // Spread expiries over every level, including past the wheel's range
+            expiries[i] = 1 + engine() % (i % 4 == 0 ? 20000000 : 100000);
+            wheel.schedule(handles[i], expiries[i], i);
+        }
+        // Cancelled timers never fire
+        for (size_t i = 0; i < handles.size(); i += 10)
+        {
+            wheel.cancel(handles[i]);
+        }
+
+        size_t fired = 0;
+        bool onTime = true;
+        while (wheel.size() > 0)
+        {
+            wheel.advance(wheel.tick() + 1 + engine() % 5000, [&](uint64_t i)
+                          {
+                fired++;
+                onTime = onTime && i % 10 != 0 && expiries[i] == wheel.tick(); });
+        }
+        EXPECT_TRUE(onTime);
+        EXPECT_EQ(fired, handles.size() - handles.size() / 10);
+    }
+
+    TEST(AlgorithmTest, ExpiringLRUCacheByteCapacity)
+    {
+        // Charge only the value length to keep the arithmetic obvious
+        auto valueLength = [](int, const string &value)
+        { return value.size(); };
+        ExpiringLRUCache<int, string, decltype(valueLength), ManualClock> cache(10, milliseconds(1), valueLength);
+
+        EXPECT_TRUE(cache.put(1, string(4, 'a')));
+        EXPECT_TRUE(cache.put(2, string(4, 'b')));
+        EXPECT_TRUE(cache.put(3, string(2, 'c')));
+        EXPECT_EQ(cache.bytes(), 10);
+        ASSERT_NE(cache.get(1), nullptr); // key 2 is now least recently used
+
+        EXPECT_TRUE(cache.put(4, string(3, 'd'))); // evicts key 2 only
+        EXPECT_EQ(cache.get(2), nullptr);
+        EXPECT_NE(cache.get(1), nullptr);
+        EXPECT_EQ(cache.bytes(), 9);
+
+        EXPECT_TRUE(cache.put(5, string(10, 'e'))); // evicts everything else
+        EXPECT_EQ(cache.size(), 1);
+        EXPECT_FALSE(cache.put(6, string(11, 'f'))); // can never fit
+        EXPECT_FALSE(cache.put(5, string(11, 'f'))); // replacing with an oversized value drops it
+        EXPECT_EQ(cache.get(5), nullptr);
+
+        CacheStats stats = cache.stats();
+        EXPECT_EQ(stats.entries, 0);
+        EXPECT_EQ(stats.chargedBytes, 0);
+        EXPECT_EQ(stats.evictions, 4);
+        EXPECT_EQ(stats.rejections, 2);
+    }
+
+    TEST(AlgorithmTest, ExpiringLRUCacheTimeToLive)
+    {
+        ExpiringLRUCache<string, string, PayloadSize, ManualClock> cache(1 << 20);
+        cache.put("short", "a", milliseconds(100));
+        cache.put("long", "b", milliseconds(5000));
+        cache.put("forever", "c");
+        cache.put("hours", "d", hours(10)); // beyond the wheel's direct range
+        EXPECT_EQ(cache.stats().pendingTimers, 3);
+
+        ManualClock::advance(milliseconds(99));
+        EXPECT_NE(cache.get("short"), nullptr);
+        ManualClock::advance(milliseconds(1));
+        EXPECT_EQ(cache.get("short"), nullptr);
+        EXPECT_NE(cache.get("long"), nullptr);
+
+        // Overwriting reschedules: the old deadline no longer applies
+        cache.put("long", "b2", milliseconds(10000));
+        ManualClock::advance(milliseconds(6000));
+        ASSERT_NE(cache.get("long"), nullptr);
+        EXPECT_EQ(*cache.get("long"), "b2");
+
+        ManualClock::advance(hours(10));
+        cache.expire();
+        EXPECT_EQ(cache.get("long"), nullptr);
+        EXPECT_EQ(cache.get("hours"), nullptr);
+        EXPECT_NE(cache.get("forever"), nullptr);
+
+        CacheStats stats = cache.stats();
+        EXPECT_EQ(stats.expirations, 3);
+        EXPECT_EQ(stats.pendingTimers, 0);
+        EXPECT_EQ(stats.entries, 1);
+        EXPECT_GT(stats.footprintBytes(), stats.chargedBytes);
+    }
+
+    // Benchmark: byte-bounded puts with a mix of short and long TTLs under a moving clock.
+    TEST(AlgorithmTest, ExpiringLRUCacheBenchmark)
+    {
+        ExpiringLRUCache<int, string, PayloadSize, ManualClock> cache(1 << 20);
+        mt19937 engine(3);
+        const int operations = 200000;
+        auto start = high_resolution_clock::now();
+        for (int i = 0; i < operations; ++i)
+        {
+            const int key = engine() % 50000;
+            if (!cache.get(key))
+            {
+                cache.put(key, string(16 + key % 512, 'x'), milliseconds(1 + engine() % 2000));
+            }
+            if (i % 100 == 0)
+            {
+                ManualClock::advance(milliseconds(1));
+            }
+        }
+        auto elapsed = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        CacheStats stats = cache.stats();
+        EXPECT_LE(stats.chargedBytes, stats.capacityBytes);
+        cout << "Run time: " << elapsed << "us, entries: " << stats.entries << ", charged: " << stats.chargedBytes
+             << " bytes, footprint: " << stats.footprintBytes() << " bytes, evictions: " << stats.evictions
+             << ", expirations: " << stats.expirations << endl;
+    }
+
+    /**
+     * Josephus problem: N people stand in a circle numbered 1..N, counting starts at person 1 and
+     * every mth person is out. Returns the number of the survivor, or -1 for invalid input.
+     *
+     * Instead of simulating, this uses the survivor's position recurrence. While n >= m, one lap
+     * around the circle removes n / m people at once. The survivor of the smaller circle is mapped
+     * back to the larger one in O(1), so these steps cost O(m log(N / m)) in total. Once n < m,
+     * the classic J(i) = (J(i - 1) + m) mod i finishes in at most m steps.
+     */
+    int64_t josephusSurvivor(int64_t N, int64_t m)
+    {
+        if (m < 1 || N < 1)
+        {
+            return -1;
+        }
+        if (m == 1)
+        {
+            return N;
+        }
+        vector<int64_t> circles; // circle sizes of each lap, replayed in reverse
+        int64_t n = N;
+        while (n >= m)
+        {
+            circles.push_back(n);
+            n -= n / m;
+        }
+        int64_t survivor = 0; // 0-based position in a circle of size n
+        for (int64_t i = 2; i <= n; ++i)
+        {
+            survivor = (survivor + m) % i;
+        }
+        for (auto it = circles.rbegin(); it != circles.rend(); ++it)
+        {
+            const int64_t size = *it;
+            survivor -= size % m;
+            if (survivor < 0)
+            {
+                survivor += size;
+            }
+            else
+            {
+                survivor += survivor / (m - 1);
+            }
+        }
+        return survivor + 1;
+    }
+
+    // Write algorithm to return the value of last man standing in circle of people
+    // where there are N people and mth is the person out.
+    int lastManStanding(int N, int m)
+    {
+        return (int)josephusSurvivor(N, m);
+    }
+
+    /**
+     * Full elimination order of the Josephus circle in O(N log N). A Fenwick tree counts who is
+     * still standing. The next victim is the ((previous rank + m - 1) mod remaining)th survivor,
+     * and it is found by binary lifting down the tree instead of walking the circle.
+     */
+    vector<int> eliminationOrder(int N, int m)
+    {
+        if (m < 1 || N < 1)
+        {
+            return {};
+        }
+        vector<int> tree(N + 1, 0);
+        for (int i = 1; i <= N; ++i)
+        {
+            // Build in O(N): each node adds itself to its parent
+            tree[i] += 1;
+            const int parent = i + (i & -i);
+            if (parent <= N)
+            {
+                tree[parent] += tree[i];
+            }
+        }
+        int topBit = 1;
+        while (topBit * 2 <= N)
+        {
+            topBit *= 2;
+        }
+
+        vector<int> order;
+        order.reserve(N);
+        int64_t rank = 0; // 0-based rank of the current counting start among survivors
+        for (int remaining = N; remaining > 0; --remaining)
+        {
+            rank = (rank + m - 1) % remaining;
+            // Find the smallest position whose prefix count exceeds rank
+            int position = 0;
+            int64_t left = rank;
+            for (int step = topBit; step > 0; step >>= 1)
+            {
+                const int next = position + step;
+                if (next <= N && tree[next] <= left)
+                {
+                    position = next;
+                    left -= tree[next];
+                }
+            }
+            const int person = position + 1;
+            order.push_back(person);
+            for (int i = person; i <= N; i += i & -i)
+            {
+                tree[i] -= 1;
+            }
+        }
+        return order;
+    }
+
+    // Original std::list simulation, O(N * m). Kept as the reference for the solvers above.
+    int lastManStandingSimulated(int N, int m)
+    {
+        if (m < 1 || N < 1)
         {
             return -1;
         }
@@ -562,46 +1827,123 @@ namespace
         assert(lastManStanding(1000, 2) == 977);  // Typical large case
     }
 
-    const unsigned CHUNK_SIZE = 50; // Define chunk size
-    int readfile(const std::string &inputFilePath, const std::string &logFilePath)
+    TEST(AlgorithmTest, JosephusSolversMatchSimulation)
+    {
+        for (int N = 1; N <= 60; ++N)
+        {
+            for (int m = 1; m <= 70; ++m)
+            {
+                const int expected = lastManStandingSimulated(N, m);
+                ASSERT_EQ(josephusSurvivor(N, m), expected) << "N=" << N << " m=" << m;
+                const vector<int> order = eliminationOrder(N, m);
+                ASSERT_EQ(order.size(), N);
+                ASSERT_EQ(order.back(), expected) << "N=" << N << " m=" << m;
+            }
+        }
+        EXPECT_EQ(eliminationOrder(7, 3), vector<int>({3, 6, 2, 7, 5, 1, 4}));
+        EXPECT_EQ(eliminationOrder(0, 3), vector<int>());
+        EXPECT_EQ(josephusSurvivor(0, 3), -1);
+
+        // Closed form for m = 2: survivor is 2L + 1 where N = 2^a + L
+        const int64_t big = 1000000000000LL;
+        int64_t power = 1;
+        while (power * 2 <= big)
+        {
+            power *= 2;
+        }
+        EXPECT_EQ(josephusSurvivor(big, 2), 2 * (big - power) + 1);
+    }
+
+    // Benchmark: survivor for N = 10^3 .. 10^9, simulation and elimination order where feasible.
+    TEST(AlgorithmTest, JosephusBenchmark)
     {
+        auto time = [](auto &&fn)
+        {
+            auto start = high_resolution_clock::now();
+            fn();
+            return duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        };
+        for (int64_t N = 1000; N <= 1000000000; N *= 10)
+        {
+            for (int m : {2, 7, 100})
+            {
+                int64_t survivor = 0;
+                auto fastUs = time([&]
+                                   { survivor = josephusSurvivor(N, m); });
+                cout << "N=" << N << " m=" << m << ": survivor " << survivor << " in " << fastUs << "us";
+                if (N <= 100000)
+                {
+                    int simulated = 0;
+                    auto simulatedUs = time([&]
+                                            { simulated = lastManStandingSimulated((int)N, m); });
+                    EXPECT_EQ(simulated, survivor);
+                    cout << ", list simulation " << simulatedUs << "us";
+                }
+                if (N <= 1000000)
+                {
+                    vector<int> order;
+                    auto orderUs = time([&]
+                                        { order = eliminationOrder((int)N, m); });
+                    EXPECT_EQ(order.back(), survivor);
+                    cout << ", elimination order " << orderUs << "us";
+                }
+                cout << endl;
+            }
+        }
+    }
 
-        std::ifstream inputFile(inputFilePath); // Input file stream
-        std::ofstream logFile(logFilePath);     // Output file stream for logging
+    const size_t CHUNK_SIZE = 1 << 20; // Default chunk size when the config does not set chunk_size
 
-        if (!inputFile || !logFile)
+    /**
+     * Stream inputFilePath to sink in chunkSize pieces and log progress to logFilePath.
+     * Regular files are memory-mapped and the sink reads straight from the mapping; anything else
+     * is read() into one large buffer. Progress is logged at most once per second.
+     */
+    int readfile(const std::string &inputFilePath, const std::string &logFilePath, ChunkSink &sink,
+                 size_t chunkSize = CHUNK_SIZE, ReadMode mode = ReadMode::Auto)
+    {
+        std::ofstream logFile(logFilePath); // Output file stream for logging
+        if (!logFile)
         {
             std::cerr << "Failed to open the file." << std::endl;
             return 1;
         }
 
-        char buffer[CHUNK_SIZE + 1]; // Buffer to hold CHUNK_SIZE characters + '\0'
-        buffer[CHUNK_SIZE] = '\0';   // Ensure the buffer is null-terminated
-
-        int totalCharsRead = 0; // Total characters read counter
-
-        while (!inputFile.eof())
+        ProgressLog progress(logFile, std::chrono::milliseconds(1000));
+        ReadOptions options;
+        options.chunkSize = chunkSize;
+        options.mode = mode;
+        if (streamFile(inputFilePath, sink, progress, options) < 0)
         {
-            inputFile.read(buffer, CHUNK_SIZE);             // Read up to CHUNK_SIZE characters
-            std::streamsize bytesRead = inputFile.gcount(); // Number of characters actually read
-
-            // Log totalCharsRead to log file
-            totalCharsRead += bytesRead;
-            logFile << "Total characters read so far: " << totalCharsRead << std::endl;
-
-            // Print the characters read (excluding any garbage beyond the end of the file)
-            std::cout.write(buffer, bytesRead);
-
-            // Check if we've reached the end of file
-            if (inputFile.eof())
-            {
-                break;
-            }
+            std::cerr << "Failed to open the file." << std::endl;
+            return 1;
         }
+        return 0;
+    }
 
-        inputFile.close(); // Close input file
-        logFile.close();   // Close log file
+    /**
+     * Pipelined readfile: this thread reads chunkSize pieces into a pool of bufferCount buffers
+     * while each of stages consumes them on its own thread, in order. Returns 1 on failure.
+     */
+    int readfileAsync(const std::string &inputFilePath, const std::string &logFilePath,
+                      const std::vector<ChunkSink *> &stages, size_t chunkSize = CHUNK_SIZE, size_t bufferCount = 4)
+    {
+        std::ofstream logFile(logFilePath); // Output file stream for logging
+        if (!logFile)
+        {
+            std::cerr << "Failed to open the file." << std::endl;
+            return 1;
+        }
 
+        ProgressLog progress(logFile, std::chrono::milliseconds(1000));
+        PipelineOptions options;
+        options.chunkSize = chunkSize;
+        options.bufferCount = bufferCount;
+        if (pipelineFile(inputFilePath, stages, progress, options) < 0)
+        {
+            std::cerr << "Failed to open the file." << std::endl;
+            return 1;
+        }
         return 0;
     }
 
@@ -610,6 +1952,8 @@ namespace
     int mul(int a, int b);
     int div(int a, int b);
 
+    // getline parser into an unordered_map, one string pair per line. ConfigTable::load took over;
+    // the ConfigTable tests still use it as the reference result and the load-time yardstick.
     unordered_map<string, string> readConfigFile(const string &filename)
     {
         unordered_map<string, string> configMap;
@@ -647,7 +1991,7 @@ namespace
      * Algorithm will group timestamps into {k} partitions at {i} seconds each.
      * Note: floor is used to group {1, 5} with partition duration of 5 into 0th partition.
      */
-    unordered_map<int, list<int>> groupTimestamps(vector<int> timestamps, int partition_duration)
+    unordered_map<int, list<int>> groupTimestamps(const vector<int> &timestamps, int partition_duration)
     {
         if (timestamps.empty())
         {
@@ -678,48 +2022,1138 @@ namespace
         assert(res.find(8) == res.end());
     }
 
-    TEST(AlgorithmTest, DataTransmission)
+    /**
+     * Timestamps grouped by partition in CSR form: partition firstPartition + i holds
+     * values[offsets[i] .. offsets[i + 1]), in input order. Partition indices are relative to the
+     * first timestamp, as in groupTimestamps, but use floor division so that timestamps before the
+     * first one land in negative partitions instead of partition 0. T is int or int64_t; the span
+     * between the earliest and latest timestamp must fit in int64_t.
+     */
+    template <typename T>
+    struct TimestampPartitions
     {
-        string filename = "config.txt"; // Replace with your config file path
-        unordered_map<string, string> configMap = readConfigFile(filename);
-        struct config
-        {
-            int chunkSize;
-            string log_file;
-            string server_url;
-        };
+        int64_t firstPartition = 0;
+        vector<size_t> offsets{0};
+        vector<T> values;
 
-        config my_config;
+        size_t partitionCount() const { return offsets.size() - 1; }
 
-        // Print out the contents of the map for verification
-        for (const auto &pair : configMap)
+        // Timestamps of partition index as [begin, end), empty if the partition has none
+        pair<const T *, const T *> partition(int64_t index) const
         {
-            if (pair.first == "chunk_size")
-            {
-                my_config.chunkSize = stoi(pair.second);
-            }
-            else if (pair.first == "log_file")
-            {
-                my_config.log_file = pair.second;
-            }
-            else if (pair.first == "server_url")
+            const int64_t i = index - firstPartition;
+            if (i < 0 || i >= (int64_t)partitionCount())
             {
-                my_config.server_url = pair.second;
+                return {nullptr, nullptr};
             }
+            return {values.data() + offsets[i], values.data() + offsets[i + 1]};
         }
-        readfile(my_config.server_url, my_config.log_file);
-        cout << "chunk size: " << my_config.chunkSize << ", server url: " << my_config.server_url << endl;
-    }
+    };
 
-    void func(int *param)
+    // Floor division for a positive divisor
+    inline int64_t floorDiv(int64_t value, int64_t divisor)
     {
-        cout << "hello " << ", temp: " << *param << endl;
-        *param = 12;
+        const int64_t quotient = value / divisor;
+        return quotient - (value % divisor < 0);
     }
 
-    bool dup(const string &input)
+    // Partition range of the timestamps: first partition index and number of partitions
+    template <typename T>
+    void sizePartitions(TimestampPartitions<T> &result, int64_t start, T minimum, T maximum, int64_t partitionDuration)
     {
-        unordered_map<char, int> map;
+        result.firstPartition = floorDiv((int64_t)minimum - start, partitionDuration);
+        const size_t partitions = (size_t)(floorDiv((int64_t)maximum - start, partitionDuration) - result.firstPartition + 1);
+        result.offsets.assign(partitions + 1, 0);
+    }
+
+    /**
+     * Group count timestamps starting at data into partitions of partitionDuration without a node
+     * per timestamp: a min/max pass sizes the offsets, a counting pass fills them and a prefix sum
+     * plus scatter pass writes the values, so the output is two flat arrays. Memory is linear in the
+     * number of timestamps plus the span of partitions between the earliest and latest one.
+     */
+    template <typename T>
+    TimestampPartitions<T> groupTimestampsFlat(const T *data, size_t count, int64_t partitionDuration)
+    {
+        TimestampPartitions<T> result;
+        if (count == 0)
+        {
+            return result;
+        }
+        const int64_t start = data[0];
+        T minimum = data[0], maximum = data[0];
+        for (size_t i = 1; i < count; ++i)
+        {
+            minimum = min(minimum, data[i]);
+            maximum = max(maximum, data[i]);
+        }
+        sizePartitions(result, start, minimum, maximum, partitionDuration);
+        const size_t partitions = result.partitionCount();
+        const int64_t base = start + result.firstPartition * partitionDuration;
+
+        // counts land one slot to the right so the prefix sum turns them into start offsets
+        for (size_t i = 0; i < count; ++i)
+        {
+            result.offsets[(size_t)(((int64_t)data[i] - base) / partitionDuration) + 1]++;
+        }
+        for (size_t p = 0; p < partitions; ++p)
+        {
+            result.offsets[p + 1] += result.offsets[p];
+        }
+        result.values.resize(count);
+        vector<size_t> cursor(result.offsets.begin(), result.offsets.end() - 1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            result.values[cursor[(size_t)(((int64_t)data[i] - base) / partitionDuration)]++] = data[i];
+        }
+        return result;
+    }
+
+    template <typename T>
+    TimestampPartitions<T> groupTimestampsFlat(const vector<T> &timestamps, int64_t partitionDuration)
+    {
+        return groupTimestampsFlat(timestamps.data(), timestamps.size(), partitionDuration);
+    }
+
+    /**
+     * groupTimestampsFlat on a thread pool, with the same output. The input is split into one
+     * contiguous slice per worker; each worker builds a histogram of its slice, a serial prefix sum
+     * over (partition, slice) gives every slice its own write cursor per partition, and the workers
+     * then scatter without locks into disjoint ranges. Slices are in input order, so values within
+     * a partition keep their input order. Histograms cost slices * partitions counters.
+     */
+    template <typename T>
+    TimestampPartitions<T> groupTimestampsParallel(const T *data, size_t count, int64_t partitionDuration, ThreadPool &pool)
+    {
+        TimestampPartitions<T> result;
+        if (count == 0)
+        {
+            return result;
+        }
+        const size_t slices = pool.chunks(count);
+        vector<pair<T, T>> ranges(slices);
+        pool.parallelFor(count, [&](size_t begin, size_t end, size_t slice)
+                         {
+            T minimum = data[begin], maximum = data[begin];
+            for (size_t i = begin + 1; i < end; ++i)
+            {
+                minimum = min(minimum, data[i]);
+                maximum = max(maximum, data[i]);
+            }
+            ranges[slice] = {minimum, maximum}; });
+        T minimum = ranges[0].first, maximum = ranges[0].second;
+        for (const auto &[low, high] : ranges)
+        {
+            minimum = min(minimum, low);
+            maximum = max(maximum, high);
+        }
+        const int64_t start = data[0];
+        sizePartitions(result, start, minimum, maximum, partitionDuration);
+        const size_t partitions = result.partitionCount();
+        const int64_t base = start + result.firstPartition * partitionDuration;
+
+        vector<vector<size_t>> histograms(slices);
+        pool.parallelFor(count, [&](size_t begin, size_t end, size_t slice)
+                         {
+            vector<size_t> &histogram = histograms[slice];
+            histogram.assign(partitions, 0);
+            for (size_t i = begin; i < end; ++i)
+            {
+                histogram[(size_t)(((int64_t)data[i] - base) / partitionDuration)]++;
+            } });
+
+        // Turn the counts into write cursors: partition-major, then slice order
+        size_t offset = 0;
+        for (size_t p = 0; p < partitions; ++p)
+        {
+            result.offsets[p] = offset;
+            for (auto &histogram : histograms)
+            {
+                const size_t n = histogram[p];
+                histogram[p] = offset;
+                offset += n;
+            }
+        }
+        result.offsets[partitions] = offset;
+
+        result.values.resize(count);
+        pool.parallelFor(count, [&](size_t begin, size_t end, size_t slice)
+                         {
+            vector<size_t> &cursor = histograms[slice];
+            T *values = result.values.data();
+            for (size_t i = begin; i < end; ++i)
+            {
+                values[cursor[(size_t)(((int64_t)data[i] - base) / partitionDuration)]++] = data[i];
+            } });
+        return result;
+    }
+
+    /**
+     * Streaming groupTimestamps for unbounded input. Partitions are relative to the first timestamp
+     * pushed. The newest windowPartitions partitions stay open, so timestamps up to that many
+     * partitions out of order are absorbed. When a timestamp opens a newer partition, the ones that
+     * fall out of the window are passed to onPartition(index, values, count) in index order (empty
+     * partitions are skipped) and their buffers are reused, so steady state does not allocate.
+     * Timestamps older than the window are late: they go to the late handler if one is set, for
+     * example to amend an already emitted partition, and are counted either way.
+     */
+    template <typename T>
+    class TimestampWindower
+    {
+    public:
+        using Callback = function<void(int64_t partition, const T *values, size_t count)>;
+        using LateHandler = function<void(int64_t partition, T timestamp)>;
+
+        TimestampWindower(int64_t partitionDuration, size_t windowPartitions, Callback onPartition)
+            : duration(partitionDuration), window(max<size_t>(1, windowPartitions)), buffers(window),
+              onPartition(std::move(onPartition))
+        {
+        }
+
+        void setLateHandler(LateHandler handler) { onLate = std::move(handler); }
+
+        void push(const T *data, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                push(data[i]);
+            }
+        }
+
+        void push(T timestamp)
+        {
+            if (!started)
+            {
+                started = true;
+                start = timestamp;
+                oldest = 0;
+                newest = 0;
+            }
+            const int64_t partition = floorDiv((int64_t)timestamp - start, duration);
+            if (partition < oldest)
+            {
+                late++;
+                if (onLate)
+                {
+                    onLate(partition, timestamp);
+                }
+                return;
+            }
+            if (partition > newest)
+            {
+                // Close everything that no longer fits in the window
+                const int64_t newOldest = partition - (int64_t)window + 1;
+                while (oldest < newOldest && oldest <= newest)
+                {
+                    emit(oldest++);
+                }
+                oldest = max(oldest, newOldest);
+                newest = partition;
+            }
+            buffers[slot(partition)].push_back(timestamp);
+        }
+
+        // Emit every open partition, e.g. at end of input
+        void flush()
+        {
+            if (!started)
+            {
+                return;
+            }
+            while (oldest <= newest)
+            {
+                emit(oldest++);
+            }
+        }
+
+        size_t lateCount() const { return late; }
+
+    private:
+        size_t slot(int64_t partition) const { return (size_t)(((partition % (int64_t)window) + (int64_t)window) % (int64_t)window); }
+
+        void emit(int64_t partition)
+        {
+            vector<T> &buffer = buffers[slot(partition)];
+            if (!buffer.empty())
+            {
+                onPartition(partition, buffer.data(), buffer.size());
+                buffer.clear(); // keeps capacity for the partition that reuses this slot
+            }
+        }
+
+        int64_t duration;
+        size_t window;
+        vector<vector<T>> buffers; // ring indexed by partition modulo window
+        Callback onPartition;
+        LateHandler onLate;
+        bool started = false;
+        int64_t start = 0;
+        int64_t oldest = 0;
+        int64_t newest = 0;
+        size_t late = 0;
+    };
+
+    TEST(AlgorithmTest, GroupTimestampsFlat)
+    {
+        const vector<int> timestamps = {1, 5, 10, 11, 12, 13, 14, 15, 20, 25, 30, 35, 40};
+        const auto expected = groupTimestamps(timestamps, 5);
+        const auto flat = groupTimestampsFlat(timestamps, 5);
+        EXPECT_EQ(flat.firstPartition, 0);
+        EXPECT_EQ(flat.values.size(), timestamps.size());
+        for (const auto &[partition, values] : expected)
+        {
+            auto [begin, end] = flat.partition(partition);
+            EXPECT_EQ(vector<int>(begin, end), vector<int>(values.begin(), values.end()));
+        }
+        size_t nonEmpty = 0;
+        for (size_t p = 0; p < flat.partitionCount(); ++p)
+        {
+            nonEmpty += flat.offsets[p + 1] > flat.offsets[p];
+        }
+        EXPECT_EQ(nonEmpty, expected.size());
+        EXPECT_EQ(flat.partition(8).first, flat.partition(8).second);
+        EXPECT_EQ(flat.partition(100).first, nullptr);
+
+        // Unsorted input, including timestamps before the first one
+        const vector<int> unsorted = {100, 93, 107, 99, 100, 85, 112};
+        const auto grouped = groupTimestampsFlat(unsorted, 5);
+        EXPECT_EQ(grouped.firstPartition, -3);
+        auto [begin, end] = grouped.partition(-2); // [90, 95)
+        EXPECT_EQ(vector<int>(begin, end), vector<int>({93}));
+        tie(begin, end) = grouped.partition(-1); // [95, 100)
+        EXPECT_EQ(vector<int>(begin, end), vector<int>({99}));
+        tie(begin, end) = grouped.partition(0); // [100, 105), in input order
+        EXPECT_EQ(vector<int>(begin, end), vector<int>({100, 100}));
+        tie(begin, end) = grouped.partition(2);
+        EXPECT_EQ(vector<int>(begin, end), vector<int>({112}));
+
+        EXPECT_EQ(groupTimestampsFlat(vector<int>(), 5).partitionCount(), 0);
+
+        // 64-bit timestamps in nanoseconds, grouped by second
+        const int64_t second = 1000000000;
+        const vector<int64_t> nanos = {1700000000 * second + 5, 1700000002 * second, 1699999999 * second + 7};
+        const auto bySecond = groupTimestampsFlat(nanos, second);
+        EXPECT_EQ(bySecond.firstPartition, -1);
+        EXPECT_EQ(bySecond.partitionCount(), 3);
+        EXPECT_EQ(*bySecond.partition(1).first, 1700000002 * second); // 2s - 5ns after the first one
+    }
+
+    TEST(AlgorithmTest, GroupTimestampsWindowed)
+    {
+        vector<int> timestamps;
+        for (int t = 0; t < 1000; t += 3)
+        {
+            timestamps.push_back(t);
+        }
+        const auto flat = groupTimestampsFlat(timestamps, 10);
+
+        // In-order input streamed in pieces gives the same partitions as the batch version
+        vector<pair<int64_t, vector<int>>> emitted;
+        TimestampWindower<int> windower(10, 4, [&](int64_t partition, const int *values, size_t count)
+                                   { emitted.push_back({partition, vector<int>(values, values + count)}); });
+        for (size_t i = 0; i < timestamps.size(); i += 7)
+        {
+            windower.push(timestamps.data() + i, min<size_t>(7, timestamps.size() - i));
+        }
+        windower.flush();
+        ASSERT_EQ(emitted.size(), flat.partitionCount());
+        for (const auto &[partition, values] : emitted)
+        {
+            auto [begin, end] = flat.partition(partition);
+            EXPECT_EQ(values, vector<int>(begin, end));
+        }
+
+        // Out-of-order within the window is absorbed, older than the window is dropped
+        emitted.clear();
+        TimestampWindower<int> late(10, 2, [&](int64_t partition, const int *values, size_t count)
+                               { emitted.push_back({partition, vector<int>(values, values + count)}); });
+        for (int t : {0, 5, 12, 3, 25, 14, 2, 31, 60})
+        {
+            late.push(t);
+        }
+        late.flush();
+        EXPECT_EQ(late.lateCount(), 1); // 2 arrives after 25 closed partition 0; 14 is still in the window
+        ASSERT_EQ(emitted.size(), 5);
+        EXPECT_EQ(emitted[0], make_pair(int64_t(0), vector<int>({0, 5, 3})));
+        EXPECT_EQ(emitted[1], make_pair(int64_t(1), vector<int>({12, 14})));
+        EXPECT_EQ(emitted[2], make_pair(int64_t(2), vector<int>({25})));
+        EXPECT_EQ(emitted[3], make_pair(int64_t(3), vector<int>({31})));
+        EXPECT_EQ(emitted[4], make_pair(int64_t(6), vector<int>({60})));
+    }
+
+    // Benchmark: map of lists vs flat CSR vs the windowed streamer on mostly ordered timestamps
+    TEST(AlgorithmTest, GroupTimestampsBenchmark)
+    {
+        const size_t count = 2000000;
+        vector<int> timestamps(count);
+        mt19937 engine(39);
+        int now = 1700000000;
+        for (auto &t : timestamps)
+        {
+            now += engine() % 3;
+            t = now;
+        }
+
+        auto start = high_resolution_clock::now();
+        const auto lists = groupTimestamps(timestamps, 60);
+        auto listsUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+        start = high_resolution_clock::now();
+        const auto flat = groupTimestampsFlat(timestamps, 60);
+        auto flatUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        EXPECT_EQ(flat.values.size(), count);
+
+        size_t streamed = 0, partitions = 0;
+        start = high_resolution_clock::now();
+        TimestampWindower<int> windower(60, 4, [&](int64_t, const int *, size_t n)
+                                   { streamed += n; partitions++; });
+        windower.push(timestamps.data(), timestamps.size());
+        windower.flush();
+        auto windowedUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        EXPECT_EQ(streamed, count);
+        EXPECT_EQ(partitions, lists.size());
+
+        cout << "Run time (" << count << " timestamps, " << lists.size() << " partitions): map of lists " << listsUs
+             << "us, flat " << flatUs << "us, windowed " << windowedUs << "us" << endl;
+    }
+
+    TEST(AlgorithmTest, GroupTimestampsParallel)
+    {
+        // Unsorted 64-bit input with a few stragglers far before the first timestamp
+        mt19937_64 engine(40);
+        vector<int64_t> timestamps(100000);
+        for (auto &t : timestamps)
+        {
+            t = 1700000000000ll + (int64_t)(engine() % 3600000);
+        }
+        timestamps[500] = 1699999000000ll;
+        timestamps[77777] = 1699999500123ll;
+
+        const auto expected = groupTimestampsFlat(timestamps, 60000);
+        for (size_t threads : {1, 2, 3, 7})
+        {
+            ThreadPool pool(threads);
+            for (size_t count : {0, 1, 2, 5, 1000, 100000})
+            {
+                const auto serial = groupTimestampsFlat(timestamps.data(), count, 60000);
+                const auto parallel = groupTimestampsParallel(timestamps.data(), count, 60000, pool);
+                EXPECT_EQ(parallel.firstPartition, serial.firstPartition);
+                EXPECT_EQ(parallel.offsets, serial.offsets);
+                EXPECT_EQ(parallel.values, serial.values); // same order within each partition
+            }
+        }
+        EXPECT_LT(expected.firstPartition, -15);
+
+        // Late arrivals in the streaming mode can be routed instead of dropped
+        vector<pair<int64_t, int64_t>> late;
+        size_t onTime = 0;
+        TimestampWindower<int64_t> windower(1000, 3, [&](int64_t, const int64_t *, size_t n)
+                                            { onTime += n; });
+        windower.setLateHandler([&](int64_t partition, int64_t timestamp)
+                                { late.push_back({partition, timestamp}); });
+        for (int64_t t : {10000, 10500, 12100, 9000, 13999, 15000, 11999, 17000})
+        {
+            windower.push(t);
+        }
+        windower.flush();
+        EXPECT_EQ(late, (vector<pair<int64_t, int64_t>>{{-1, 9000}, {1, 11999}}));
+        EXPECT_EQ(windower.lateCount(), 2);
+        EXPECT_EQ(onTime, 6);
+    }
+
+    // Benchmark: serial flat grouping vs the parallel histogram version from 1 thread up to all
+    // hardware threads, on unsorted 64-bit timestamps.
+    TEST(AlgorithmTest, GroupTimestampsParallelBenchmark)
+    {
+        const size_t count = 4000000;
+        mt19937_64 engine(41);
+        vector<int64_t> timestamps(count);
+        for (auto &t : timestamps)
+        {
+            t = 1700000000000ll + (int64_t)(engine() % 86400000); // one day in milliseconds
+        }
+
+        auto start = high_resolution_clock::now();
+        const auto serial = groupTimestampsFlat(timestamps, 60000);
+        auto serialUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        cout << "Run time (" << count << " timestamps, " << serial.partitionCount() << " partitions): serial " << serialUs << "us";
+
+        const size_t cores = max(1u, thread::hardware_concurrency());
+        for (size_t threads = 1;; threads = min(threads * 2, cores))
+        {
+            ThreadPool pool(threads);
+            start = high_resolution_clock::now();
+            const auto parallel = groupTimestampsParallel(timestamps.data(), count, 60000, pool);
+            auto us = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+            EXPECT_EQ(parallel.offsets, serial.offsets);
+            cout << ", " << threads << " threads " << us << "us";
+            if (threads == cores)
+            {
+                break;
+            }
+        }
+        cout << endl;
+    }
+
+    TEST(AlgorithmTest, DataTransmission)
+    {
+        string filename = "config.txt"; // Replace with your config file path
+        ConfigService configService(filename, false); // pass true to pick up edits while running
+        const auto configTable = configService.read();
+        struct config
+        {
+            int chunkSize = CHUNK_SIZE;
+            int bufferCount = 4;
+            string log_file;
+            string server_url;
+        };
+
+        config my_config;
+        my_config.chunkSize = (int)configTable->getInt("chunk_size").value_or(CHUNK_SIZE);
+        my_config.bufferCount = (int)configTable->getInt("buffer_count").value_or(4);
+        my_config.log_file = string(configTable->get("log_file").value_or(""));
+        my_config.server_url = string(configTable->get("server_url").value_or(""));
+
+        StreamSink out(cout);
+        readfileAsync(my_config.server_url, my_config.log_file, {&out}, my_config.chunkSize, my_config.bufferCount);
+        cout << "chunk size: " << my_config.chunkSize << ", server url: " << my_config.server_url << endl;
+    }
+
+    TEST(AlgorithmTest, ConfigTable)
+    {
+        const string text = "# comment without a delimiter\n"
+                            "  chunk_size =  4096 \r\n"
+                            "server_url=http://example.com/a=b\n"
+                            "\n"
+                            "ratio = 0.25\n"
+                            "enabled = yes\n"
+                            "retries = 3\n"
+                            "retries = 5\n"
+                            "timeout = 10ms\n"
+                            "empty =\n"
+                            "last_line_without_newline=end";
+        const ConfigTable table = ConfigTable::fromText(text);
+        EXPECT_TRUE(table.ok());
+        EXPECT_EQ(table.size(), 8);
+        EXPECT_EQ(table.getInt("chunk_size"), 4096);
+        EXPECT_EQ(table.get("server_url"), "http://example.com/a=b");
+        EXPECT_EQ(table.getDouble("ratio"), 0.25);
+        EXPECT_EQ(table.getBool("enabled"), true);
+        EXPECT_EQ(table.getInt("retries"), 5); // the last duplicate wins
+        EXPECT_EQ(table.get("timeout"), "10ms");
+        EXPECT_FALSE(table.getInt("timeout").has_value());
+        EXPECT_EQ(table.get("empty"), "");
+        EXPECT_FALSE(table.getInt("empty").has_value());
+        EXPECT_EQ(table.get("last_line_without_newline"), "end");
+        EXPECT_FALSE(table.contains("missing"));
+        EXPECT_FALSE(table.get("missing").has_value());
+
+        // Same result as the original parser when loaded from disk
+        const string path = ::testing::TempDir() + "config_table.txt";
+        {
+            ofstream file(path, ios::binary);
+            file << text;
+        }
+        const ConfigTable loaded = ConfigTable::load(path);
+        const auto expected = readConfigFile(path);
+        EXPECT_TRUE(loaded.ok());
+        EXPECT_EQ(loaded.size(), expected.size());
+        loaded.forEach([&](string_view key, string_view value)
+                       {
+            auto it = expected.find(string(key));
+            ASSERT_NE(it, expected.end());
+            EXPECT_EQ(it->second, value); });
+
+        const ConfigTable missing = ConfigTable::load(::testing::TempDir() + "does_not_exist");
+        EXPECT_FALSE(missing.ok());
+        EXPECT_EQ(missing.size(), 0);
+    }
+
+    // Benchmark: readConfigFile vs ConfigTable::load on a 1M-line config, then 1M typed lookups
+    // (stoi on every lookup vs an integer parsed at load time).
+    TEST(AlgorithmTest, ConfigTableBenchmark)
+    {
+        const int lines = 1000000;
+        const string path = ::testing::TempDir() + "config_bench.txt";
+        {
+            ofstream file(path, ios::binary);
+            for (int i = 0; i < lines; ++i)
+            {
+                file << "  service." << i << ".limit = " << i * 7 << "\n";
+            }
+        }
+
+        auto start = high_resolution_clock::now();
+        const auto map = readConfigFile(path);
+        auto mapLoadUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+        start = high_resolution_clock::now();
+        const ConfigTable table = ConfigTable::load(path);
+        auto tableLoadUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        ASSERT_EQ(table.size(), map.size());
+
+        vector<string> keys;
+        keys.reserve(lines);
+        mt19937 engine(37);
+        for (int i = 0; i < lines; ++i)
+        {
+            keys.push_back("service." + to_string(engine() % lines) + ".limit");
+        }
+
+        int64_t mapSum = 0, tableSum = 0;
+        start = high_resolution_clock::now();
+        for (const auto &key : keys)
+        {
+            mapSum += stoi(map.at(key));
+        }
+        auto mapLookupUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        for (const auto &key : keys)
+        {
+            tableSum += *table.getInt(key);
+        }
+        auto tableLookupUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        EXPECT_EQ(mapSum, tableSum);
+
+        cout << "Run time (" << lines << " lines): load readConfigFile " << mapLoadUs << "us, ConfigTable " << tableLoadUs
+             << "us; " << lines << " int lookups unordered_map+stoi " << mapLookupUs << "us, ConfigTable "
+             << tableLookupUs << "us" << endl;
+    }
+
+    void writeConfig(const string &path, int value)
+    {
+        ofstream file(path, ios::binary);
+        file << "first = " << value << "\nsecond = " << value << "\n";
+    }
+
+    TEST(AlgorithmTest, ConfigServiceReload)
+    {
+        const string path = ::testing::TempDir() + "config_service.txt";
+        writeConfig(path, 1);
+        ConfigService service(path);
+        ASSERT_TRUE(service.watching());
+        EXPECT_EQ(service.version(), 1);
+        EXPECT_EQ(service.read()->getInt("first"), 1);
+
+        // Rewriting the file is picked up by the watcher
+        {
+            auto held = service.read(); // an old snapshot stays readable while a reload waits for it
+            writeConfig(path, 2);
+            this_thread::sleep_for(std::chrono::milliseconds(20));
+            EXPECT_EQ(held->getInt("first"), 1);
+        }
+        ASSERT_TRUE(service.waitForNewerThan(1, std::chrono::milliseconds(5000)));
+        EXPECT_EQ(service.read()->getInt("first"), 2);
+
+        // So is replacing it by rename, as editors do
+        const uint64_t version = service.version();
+        const string staged = path + ".new";
+        writeConfig(staged, 3);
+        ASSERT_EQ(rename(staged.c_str(), path.c_str()), 0);
+        ASSERT_TRUE(service.waitForNewerThan(version, std::chrono::milliseconds(5000)));
+        EXPECT_EQ(service.read()->getInt("second"), 3);
+
+        // A missing file keeps the last good snapshot
+        ConfigService manual(::testing::TempDir() + "config_service_missing.txt", false);
+        EXPECT_FALSE(manual.watching());
+        EXPECT_FALSE(manual.reload());
+        EXPECT_EQ(manual.version(), 1);
+        EXPECT_FALSE(manual.read()->ok());
+    }
+
+    // reload() waits for every reader of the old snapshot, including one on the calling thread
+    TEST(AlgorithmTest, ConfigServiceReloadInsideReadGuard)
+    {
+        const string path = ::testing::TempDir() + "config_service_guarded.txt";
+        writeConfig(path, 1);
+        ConfigService first(path, false), second(path, false);
+        {
+            auto held = first.read(); // a guard of another service does not block this reload
+            EXPECT_TRUE(second.reload());
+        }
+#ifndef NDEBUG // without the assert this would hang instead
+        EXPECT_DEATH(
+            {
+                auto held = second.read();
+                second.reload();
+            },
+            "holding one of its ReadGuards");
+#endif
+    }
+
+    TEST(AlgorithmTest, ConfigServiceConcurrentReaders)
+    {
+        const string path = ::testing::TempDir() + "config_service_concurrent.txt";
+        writeConfig(path, 0);
+        ConfigService service(path, false);
+
+        // Readers must always see both keys of one snapshot, never a mix or a freed table
+        atomic<bool> done{false};
+        atomic<int64_t> reads{0};
+        atomic<int> torn{0};
+        vector<thread> readers;
+        for (int t = 0; t < 4; ++t)
+        {
+            readers.emplace_back([&]
+                                 {
+                int64_t last = 0;
+                while (!done.load())
+                {
+                    auto snapshot = service.read();
+                    const int64_t first = *snapshot->getInt("first");
+                    if (first != *snapshot->getInt("second") || first < last)
+                    {
+                        torn++;
+                    }
+                    last = first;
+                    reads++;
+                } });
+        }
+        for (int i = 1; i <= 200; ++i)
+        {
+            writeConfig(path, i);
+            ASSERT_TRUE(service.reload());
+        }
+        done = true;
+        for (auto &reader : readers)
+        {
+            reader.join();
+        }
+        EXPECT_EQ(torn.load(), 0);
+        EXPECT_GT(reads.load(), 0);
+        EXPECT_EQ(service.version(), 201);
+        EXPECT_EQ(service.read()->getInt("first"), 200);
+    }
+
+    // Benchmark: reader overhead of ConfigService::read() against a bare table and a mutex-guarded
+    // shared_ptr copy, and the latency from writing the file to the new snapshot being published.
+    TEST(AlgorithmTest, ConfigServiceBenchmark)
+    {
+        const string path = ::testing::TempDir() + "config_service_bench.txt";
+        writeConfig(path, 7);
+        ConfigService service(path);
+        const int reads = 1000000;
+
+        int64_t sum = 0;
+        auto start = high_resolution_clock::now();
+        {
+            auto snapshot = service.read();
+            for (int i = 0; i < reads; ++i)
+            {
+                sum += *snapshot->getInt("first");
+            }
+        }
+        auto bareUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+        start = high_resolution_clock::now();
+        for (int i = 0; i < reads; ++i)
+        {
+            sum += *service.read()->getInt("first");
+        }
+        auto guardedUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+        mutex lock;
+        auto shared = make_shared<ConfigTable>(ConfigTable::load(path));
+        start = high_resolution_clock::now();
+        for (int i = 0; i < reads; ++i)
+        {
+            shared_ptr<ConfigTable> copy;
+            {
+                lock_guard<mutex> guard(lock);
+                copy = shared;
+            }
+            sum += *copy->getInt("first");
+        }
+        auto mutexUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        EXPECT_EQ(sum, 3 * 7 * (int64_t)reads);
+
+        const int reloads = 20;
+        long long latencyUs = 0;
+        for (int i = 0; i < reloads; ++i)
+        {
+            const uint64_t version = service.version();
+            start = high_resolution_clock::now();
+            writeConfig(path, i);
+            ASSERT_TRUE(service.waitForNewerThan(version, std::chrono::milliseconds(5000)));
+            latencyUs += duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        }
+
+        cout << "Run time (" << reads << " reads): held snapshot " << bareUs << "us, read() per lookup " << guardedUs
+             << "us, mutex + shared_ptr copy " << mutexUs << "us; reload latency " << latencyUs / reloads
+             << "us average over " << reloads << " writes" << endl;
+    }
+
+    // Sink that keeps a copy of everything it receives
+    class CollectSink : public ChunkSink
+    {
+    public:
+        void consume(const char *data, size_t size) override
+        {
+            data_.append(data, size);
+            chunks++;
+        }
+        const string &data() const { return data_; }
+        size_t chunks = 0;
+
+    private:
+        string data_;
+    };
+
+    // Sink that only checksums, so benchmarks measure reading rather than copying
+    class ChecksumSink : public ChunkSink
+    {
+    public:
+        void consume(const char *data, size_t size) override
+        {
+            for (size_t i = 0; i < size; i += 64)
+            {
+                sum += (unsigned char)data[i];
+            }
+            bytes += size;
+        }
+        uint64_t sum = 0;
+        uint64_t bytes = 0;
+    };
+
+    string writeTempFile(const string &name, size_t size)
+    {
+        const string path = ::testing::TempDir() + name;
+        ofstream file(path, ios::binary);
+        mt19937 engine((unsigned)size);
+        string block(64 * 1024, '\0');
+        for (size_t written = 0; written < size; written += block.size())
+        {
+            generate(block.begin(), block.end(), [&]
+                     { return (char)('a' + engine() % 26); });
+            file.write(block.data(), min(block.size(), size - written));
+        }
+        return path;
+    }
+
+    TEST(AlgorithmTest, ReadFileChunking)
+    {
+        const string input = writeTempFile("readfile_input.txt", 100000);
+        const string log = ::testing::TempDir() + "readfile.log";
+        ifstream file(input, ios::binary);
+        const string expected((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+        for (ReadMode mode : {ReadMode::Auto, ReadMode::Mapped, ReadMode::Buffered, ReadMode::Uring, ReadMode::Pread})
+        {
+            for (size_t chunkSize : {1, 7, 50, 4096, 1 << 20})
+            {
+                CollectSink sink;
+                ASSERT_EQ(readfile(input, log, sink, chunkSize, mode), 0);
+                EXPECT_EQ(sink.data(), expected);
+                EXPECT_EQ(sink.chunks, (expected.size() + chunkSize - 1) / chunkSize);
+            }
+        }
+
+        // Progress is rate limited: a fast read logs the first chunk and the final total only
+        CollectSink sink;
+        ASSERT_EQ(readfile(input, log, sink, 50), 0);
+        ifstream logFile(log);
+        string line, last;
+        size_t lines = 0;
+        while (getline(logFile, line))
+        {
+            last = line;
+            lines++;
+        }
+        EXPECT_LE(lines, 3);
+        EXPECT_EQ(last, "Total characters read so far: 100000");
+
+        // Empty and missing files
+        const string empty = writeTempFile("readfile_empty.txt", 0);
+        CollectSink emptySink;
+        EXPECT_EQ(readfile(empty, log, emptySink, 50, ReadMode::Mapped), 0);
+        EXPECT_EQ(emptySink.chunks, 0);
+        EXPECT_EQ(readfile(::testing::TempDir() + "does_not_exist", log, emptySink), 1);
+    }
+
+    // Benchmark: the original 50-byte ifstream loop with a flushed log line per chunk vs the
+    // buffered and memory-mapped readers with 1 MiB chunks.
+    TEST(AlgorithmTest, ReadFileBenchmark)
+    {
+        const size_t size = 16 << 20;
+        const string input = writeTempFile("readfile_bench.bin", size);
+        const string log = ::testing::TempDir() + "readfile_bench.log";
+
+        auto start = high_resolution_clock::now();
+        {
+            ifstream inputFile(input);
+            ofstream logFile(log);
+            char buffer[50];
+            ChecksumSink sink;
+            int totalCharsRead = 0;
+            while (!inputFile.eof())
+            {
+                inputFile.read(buffer, sizeof(buffer));
+                totalCharsRead += inputFile.gcount();
+                logFile << "Total characters read so far: " << totalCharsRead << std::endl;
+                sink.consume(buffer, inputFile.gcount());
+            }
+            EXPECT_EQ(sink.bytes, size);
+        }
+        auto legacyUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+        auto run = [&](ReadMode mode)
+        {
+            ChecksumSink sink;
+            auto begin = high_resolution_clock::now();
+            EXPECT_EQ(readfile(input, log, sink, 1 << 20, mode), 0);
+            auto us = duration_cast<microseconds>(high_resolution_clock::now() - begin).count();
+            EXPECT_EQ(sink.bytes, size);
+            return us;
+        };
+        auto bufferedUs = run(ReadMode::Buffered);
+        auto mappedUs = run(ReadMode::Mapped);
+        auto mbPerSecond = [&](long long us)
+        { return us == 0 ? 0 : (long long)(size / us); };
+        cout << "Run time (" << (size >> 20) << " MiB): 50-byte ifstream " << legacyUs << "us ("
+             << mbPerSecond(legacyUs) << " MB/s), read() " << bufferedUs << "us (" << mbPerSecond(bufferedUs)
+             << " MB/s), mmap " << mappedUs << "us (" << mbPerSecond(mappedUs) << " MB/s)" << endl;
+    }
+
+    TEST(AlgorithmTest, ReadFileUring)
+    {
+        const string input = writeTempFile("uring_input.txt", 1000003);
+        const string log = ::testing::TempDir() + "uring.log";
+        ifstream file(input, ios::binary);
+        const string expected((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+        for (unsigned queueDepth : {1, 2, 8, 64})
+        {
+            for (size_t chunkSize : {4096, 65536, 1 << 20, 4 << 20})
+            {
+                ofstream logFile(log);
+                ProgressLog progress(logFile, std::chrono::milliseconds(1000));
+                ReadOptions options;
+                options.chunkSize = chunkSize;
+                options.mode = ReadMode::Uring;
+                options.queueDepth = queueDepth;
+                ReadStats stats;
+                CollectSink sink;
+                ASSERT_EQ(streamFile(input, sink, progress, options, &stats), (int64_t)expected.size());
+                EXPECT_EQ(sink.data(), expected);
+                EXPECT_EQ(sink.chunks, (expected.size() + chunkSize - 1) / chunkSize);
+                if (stats.usedUring)
+                {
+                    // One io_uring_enter can complete several chunks, never fewer than one
+                    EXPECT_LE(stats.syscalls, sink.chunks + 1);
+                }
+            }
+        }
+
+        // Non-regular files are read() like the buffered mode
+        CollectSink sink;
+        ASSERT_EQ(readfile("/dev/null", log, sink, 4096, ReadMode::Uring), 0);
+        EXPECT_EQ(sink.chunks, 0);
+    }
+
+    // Read syscalls made by this process so far (syscr in /proc/self/io), or 0 if unavailable
+    uint64_t readSyscallCount()
+    {
+        ifstream io("/proc/self/io");
+        string key;
+        uint64_t value;
+        while (io >> key >> value)
+        {
+            if (key == "syscr:")
+            {
+                return value;
+            }
+        }
+        return 0;
+    }
+
+    // Benchmark: iostream reads vs pread() vs io_uring on a page-cache-hot file, in GB/s and
+    // syscalls per GB. io_uring_enter is not a read syscall, so the io_uring path counts its own.
+    TEST(AlgorithmTest, ReadFileUringBenchmark)
+    {
+        const size_t size = 64 << 20;
+        const string input = writeTempFile("uring_bench.bin", size);
+        const string log = ::testing::TempDir() + "uring_bench.log";
+        const double gigabytes = size / 1e9;
+
+        auto report = [&](const string &name, long long us, uint64_t syscalls)
+        {
+            cout << "  " << name << ": " << us << "us, " << (us == 0 ? 0 : gigabytes / (us / 1e6)) << " GB/s, "
+                 << syscalls / gigabytes << " syscalls/GB" << endl;
+        };
+        cout << "Run time (" << (size >> 20) << " MiB):" << endl;
+
+        for (size_t chunkSize : {size_t(50), size_t(1) << 20})
+        {
+            ChecksumSink sink;
+            const uint64_t before = readSyscallCount();
+            auto start = high_resolution_clock::now();
+            ifstream inputFile(input, ios::binary);
+            vector<char> buffer(chunkSize);
+            while (inputFile.read(buffer.data(), buffer.size()) || inputFile.gcount() > 0)
+            {
+                sink.consume(buffer.data(), inputFile.gcount());
+            }
+            auto us = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+            EXPECT_EQ(sink.bytes, size);
+            report("ifstream " + to_string(chunkSize) + "B chunks", us, readSyscallCount() - before);
+        }
+
+        for (ReadMode mode : {ReadMode::Pread, ReadMode::Uring})
+        {
+            ofstream logFile(log);
+            ProgressLog progress(logFile, std::chrono::milliseconds(1000));
+            ReadOptions options;
+            options.mode = mode;
+            options.queueDepth = 16;
+            ReadStats stats;
+            ChecksumSink sink;
+            auto start = high_resolution_clock::now();
+            EXPECT_EQ(streamFile(input, sink, progress, options, &stats), (int64_t)size);
+            auto us = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+            string name = mode == ReadMode::Pread ? "pread 1MiB chunks"
+                          : stats.usedUring   ? string("io_uring 1MiB chunks, depth 16") + (stats.registeredBuffers ? ", registered" : "")
+                                              : "io_uring unavailable, pread fallback";
+            report(name, us, stats.syscalls);
+        }
+    }
+
+    // Stage that hashes every byte (FNV-1a), standing in for per-chunk processing
+    class HashSink : public ChunkSink
+    {
+    public:
+        void consume(const char *data, size_t size) override
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+            }
+        }
+        uint64_t hash = 14695981039346656037ull;
+    };
+
+    // Sink that fails after a number of chunks
+    class ThrowingSink : public ChunkSink
+    {
+    public:
+        explicit ThrowingSink(size_t failAt) : failAt(failAt) {}
+        void consume(const char *, size_t) override
+        {
+            if (++seen == failAt)
+            {
+                throw runtime_error("sink failed");
+            }
+        }
+
+    private:
+        size_t failAt;
+        size_t seen = 0;
+    };
+
+    TEST(AlgorithmTest, ReadFilePipeline)
+    {
+        const string input = writeTempFile("pipeline_input.txt", 300000);
+        const string log = ::testing::TempDir() + "pipeline.log";
+        ifstream file(input, ios::binary);
+        const string expected((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+
+        for (size_t stageCount : {1, 2, 3})
+        {
+            for (size_t bufferCount : {1, 2, 8})
+            {
+                for (size_t chunkSize : {1000, 4096, 1 << 20})
+                {
+                    vector<CollectSink> sinks(stageCount);
+                    vector<ChunkSink *> stages;
+                    for (auto &sink : sinks)
+                    {
+                        stages.push_back(&sink);
+                    }
+                    ASSERT_EQ(readfileAsync(input, log, stages, chunkSize, bufferCount), 0);
+                    for (const auto &sink : sinks)
+                    {
+                        EXPECT_EQ(sink.data(), expected);
+                        EXPECT_EQ(sink.chunks, (expected.size() + chunkSize - 1) / chunkSize);
+                    }
+                }
+            }
+        }
+
+        CollectSink sink;
+        EXPECT_EQ(readfileAsync(::testing::TempDir() + "does_not_exist", log, {&sink}), 1);
+        const string empty = writeTempFile("pipeline_empty.txt", 0);
+        EXPECT_EQ(readfileAsync(empty, log, {&sink}), 0);
+        EXPECT_EQ(sink.chunks, 0);
+
+        // A failing stage stops the reader and the exception reaches the caller
+        ThrowingSink failing(3);
+        CollectSink after;
+        EXPECT_THROW(readfileAsync(input, log, {&failing, &after}, 1000, 2), runtime_error);
+        EXPECT_LT(after.chunks, 300);
+    }
+
+    // Benchmark: synchronous read -> hash -> write loop vs the pipelined reader with the hash and
+    // the write as separate stages, so reading, hashing and writing overlap.
+    TEST(AlgorithmTest, ReadFilePipelineBenchmark)
+    {
+        const size_t size = 16 << 20;
+        const string input = writeTempFile("pipeline_bench.bin", size);
+        const string log = ::testing::TempDir() + "pipeline_bench.log";
+        const string output = ::testing::TempDir() + "pipeline_bench.out";
+
+        // One sink that runs both stages back to back, as the synchronous loop does
+        struct SerialSink : ChunkSink
+        {
+            SerialSink(ChunkSink &first, ChunkSink &second) : first(first), second(second) {}
+            void consume(const char *data, size_t size) override
+            {
+                first.consume(data, size);
+                second.consume(data, size);
+            }
+            ChunkSink &first;
+            ChunkSink &second;
+        };
+
+        uint64_t serialHash, pipelinedHash;
+        auto start = high_resolution_clock::now();
+        {
+            ofstream out(output, ios::binary);
+            HashSink hash;
+            StreamSink write(out);
+            SerialSink serial(hash, write);
+            EXPECT_EQ(readfile(input, log, serial, 1 << 20, ReadMode::Buffered), 0);
+            serialHash = hash.hash;
+        }
+        auto serialUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+        start = high_resolution_clock::now();
+        {
+            ofstream out(output, ios::binary);
+            HashSink hash;
+            StreamSink write(out);
+            EXPECT_EQ(readfileAsync(input, log, {&hash, &write}, 1 << 20, 4), 0);
+            pipelinedHash = hash.hash;
+        }
+        auto pipelinedUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        EXPECT_EQ(serialHash, pipelinedHash);
+
+        auto mbPerSecond = [&](long long us)
+        { return us == 0 ? 0 : (long long)(size / us); };
+        cout << "Run time (" << (size >> 20) << " MiB, " << thread::hardware_concurrency()
+             << " hardware threads): synchronous " << serialUs << "us (" << mbPerSecond(serialUs)
+             << " MB/s), pipelined " << pipelinedUs << "us (" << mbPerSecond(pipelinedUs) << " MB/s)" << endl;
+    }
+
+    void func(int *param)
+    {
+        cout << "hello " << ", temp: " << *param << endl;
+        *param = 12;
+    }
+
+    // Counts every character in a hash map before answering. dup() needs only a 256-bit seen set,
+    // and the dup tests check the two agree on lengths either side of the 256-byte pigeonhole shortcut.
+    bool dupWithMap(const string &input)
+    {
+        unordered_map<char, int> map;
         for (int i = 0; i < input.size(); ++i)
         {
             map[input[i]]++;
@@ -732,13 +3166,138 @@ namespace
     }
 
     /**
-     *  Write an algorithm that will return true if input string is a mirror of itself, false otherwise
-     *  Eg: abba = true
-     *      abcb = false
-     *  Option 1. -> ab ba -> ab ab -> a-a=0 b-b=0 if !0, then it's not mirror string
-     *  Option 2. -> two ptrs, if ptrs pointing to same char -> good, else, not a mirror string
+     * True if any byte occurs twice. One bit per byte value in a 256-bit bitmap replaces the
+     * map: a test and a set per byte, no allocation. A string longer than 256 bytes must repeat
+     * a byte, so long strings are answered without reading them; a vector path would have nothing
+     * left to speed up.
      */
-    bool isMirrorString(const string &input)
+    bool dup(string_view input)
+    {
+        if (input.size() > 256)
+        {
+            return true;
+        }
+        uint64_t seen[4] = {0, 0, 0, 0};
+        for (unsigned char c : input)
+        {
+            const uint64_t bit = 1ull << (c & 63);
+            if (seen[c >> 6] & bit)
+            {
+                return true;
+            }
+            seen[c >> 6] |= bit;
+        }
+        return false;
+    }
+
+    // Byte-by-byte palindrome check, the reference for the vector versions
+    bool isPalindromeScalar(const char *data, size_t size)
+    {
+        for (size_t i = 0, j = size; i + 1 < j; ++i, --j)
+        {
+            if (data[i] != data[j - 1])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#if defined(__SSE2__)
+    // Reverse the 16 bytes of v with SSE2 only: swap 32-bit lanes, then 16-bit words, then bytes
+    inline __m128i reverseBytes(__m128i v)
+    {
+        v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    }
+
+    // Compare 16 bytes from the front with the reversed 16 bytes that end at the mirror position
+    bool isPalindromeSSE2(const char *data, size_t size)
+    {
+        if (size < 32)
+        {
+            return isPalindromeScalar(data, size);
+        }
+        size_t i = 0;
+        for (; i + 16 <= size / 2; i += 16)
+        {
+            const __m128i front = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            const __m128i back = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + size - i - 16));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(front, reverseBytes(back))) != 0xFFFF)
+            {
+                return false;
+            }
+        }
+        return isPalindromeScalar(data + i, size - 2 * i);
+    }
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+    // 32 bytes at a time: reverse within each 128-bit lane with pshufb, then swap the lanes
+    __attribute__((target("avx2"))) bool isPalindromeAVX2(const char *data, size_t size)
+    {
+        if (size < 64)
+        {
+#if defined(__SSE2__)
+            return isPalindromeSSE2(data, size);
+#else
+            return isPalindromeScalar(data, size);
+#endif
+        }
+        const __m256i reverse = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+                                                 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        size_t i = 0;
+        for (; i + 32 <= size / 2; i += 32)
+        {
+            const __m256i front = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            __m256i back = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + size - i - 32));
+            back = _mm256_permute2x128_si256(_mm256_shuffle_epi8(back, reverse), back, 0x01);
+            if ((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(front, back)) != 0xFFFFFFFFu)
+            {
+                return false;
+            }
+        }
+#if defined(__SSE2__)
+        return isPalindromeSSE2(data + i, size - 2 * i);
+#else
+        return isPalindromeScalar(data + i, size - 2 * i);
+#endif
+    }
+#endif
+
+    using PalindromeCheck = bool (*)(const char *, size_t);
+
+    // Widest implementation the CPU supports, picked once
+    PalindromeCheck palindromeCheck()
+    {
+        static const PalindromeCheck check = []() -> PalindromeCheck
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            if (__builtin_cpu_supports("avx2"))
+            {
+                return isPalindromeAVX2;
+            }
+#endif
+#if defined(__SSE2__)
+            return isPalindromeSSE2;
+#else
+            return isPalindromeScalar;
+#endif
+        }();
+        return check;
+    }
+
+    // True if input reads the same backwards; the empty string is a palindrome
+    bool isPalindrome(string_view input)
+    {
+        return palindromeCheck()(input.data(), input.size());
+    }
+
+    // Byte-at-a-time two-pointer check, which isMirrorString() now hands to the SIMD palindrome
+    // kernels; the palindrome tests compare both on the same inputs.
+    bool isMirrorStringScalar(const string &input)
     {
         if (input.empty())
         {
@@ -766,6 +3325,63 @@ namespace
         return true;
     }
 
+    /**
+     *  Write an algorithm that will return true if input string is a mirror of itself, false otherwise
+     *  Eg: abba = true
+     *      abcb = false
+     *  Option 1. -> ab ba -> ab ab -> a-a=0 b-b=0 if !0, then it's not mirror string
+     *  Option 2. -> two ptrs, if ptrs pointing to same char -> good, else, not a mirror string
+     *  A mirror string is a non-empty, even-length palindrome, so the check is the vectorized
+     *  reverse-compare of isPalindrome.
+     */
+    bool isMirrorString(string_view input)
+    {
+        return !input.empty() && input.size() % 2 == 0 && isPalindrome(input);
+    }
+
+    /**
+     * Batch versions: results[i] is set to the answer for inputs[i] and the number of true answers
+     * is returned. results is resized, so reusing it across calls does not allocate.
+     */
+    size_t dupBatch(const vector<string_view> &inputs, vector<uint8_t> &results)
+    {
+        results.resize(inputs.size());
+        size_t found = 0;
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            results[i] = dup(inputs[i]);
+            found += results[i];
+        }
+        return found;
+    }
+
+    size_t isPalindromeBatch(const vector<string_view> &inputs, vector<uint8_t> &results)
+    {
+        const PalindromeCheck check = palindromeCheck();
+        results.resize(inputs.size());
+        size_t found = 0;
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            results[i] = check(inputs[i].data(), inputs[i].size());
+            found += results[i];
+        }
+        return found;
+    }
+
+    size_t isMirrorStringBatch(const vector<string_view> &inputs, vector<uint8_t> &results)
+    {
+        const PalindromeCheck check = palindromeCheck();
+        results.resize(inputs.size());
+        size_t found = 0;
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            const string_view input = inputs[i];
+            results[i] = !input.empty() && input.size() % 2 == 0 && check(input.data(), input.size());
+            found += results[i];
+        }
+        return found;
+    }
+
     TEST(AlgorithmTest, MirrorStringTest)
     {
         int o = 10;
@@ -784,6 +3400,127 @@ namespace
         assert(!isMirrorString("1111111"));
         assert(isMirrorString("11"));
     }
+
+    TEST(AlgorithmTest, DupAndPalindromeVectorized)
+    {
+        // dup agrees with the map version, including bytes above 127 and strings over 256 bytes
+        mt19937 engine(41);
+        for (size_t length : {0, 1, 2, 15, 16, 17, 40, 100, 255, 256, 257, 1000})
+        {
+            for (int trial = 0; trial < 20; ++trial)
+            {
+                string input(length, '\0');
+                if (length <= 256)
+                {
+                    // A permutation prefix of all byte values has no repeats; maybe plant one
+                    string bytes(256, '\0');
+                    iota(bytes.begin(), bytes.end(), 0);
+                    shuffle(bytes.begin(), bytes.end(), engine);
+                    input = bytes.substr(0, length);
+                    if (length > 1 && trial % 2)
+                    {
+                        input[engine() % length] = input[engine() % length];
+                    }
+                }
+                else
+                {
+                    generate(input.begin(), input.end(), [&]
+                             { return (char)engine(); });
+                }
+                EXPECT_EQ(dup(input), dupWithMap(input)) << "length " << length;
+            }
+        }
+
+        // Every implementation agrees with the scalar check, around the 16 and 32 byte boundaries
+        vector<PalindromeCheck> checks = {isPalindromeScalar};
+#if defined(__SSE2__)
+        checks.push_back(isPalindromeSSE2);
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+        if (__builtin_cpu_supports("avx2"))
+        {
+            checks.push_back(isPalindromeAVX2);
+        }
+#endif
+        for (size_t length = 0; length <= 150; ++length)
+        {
+            string palindrome(length, 'a');
+            for (size_t i = 0; i < (length + 1) / 2; ++i)
+            {
+                palindrome[i] = palindrome[length - 1 - i] = (char)('a' + engine() % 26);
+            }
+            for (PalindromeCheck check : checks)
+            {
+                EXPECT_TRUE(check(palindrome.data(), palindrome.size())) << length;
+                // Break the mirror at every position of the first half
+                for (size_t i = 0; i < length / 2; ++i)
+                {
+                    string broken = palindrome;
+                    broken[i] = broken[i] == 'z' ? 'y' : 'z';
+                    EXPECT_FALSE(check(broken.data(), broken.size())) << length << " at " << i;
+                }
+            }
+            EXPECT_EQ(isMirrorString(palindrome), length > 0 && length % 2 == 0);
+            EXPECT_EQ(isMirrorString(palindrome), isMirrorStringScalar(palindrome));
+        }
+
+        vector<string> words = {"abba", "abc", "", "racecar", "noon", "aa", "xyz", "a"};
+        vector<string_view> views(words.begin(), words.end());
+        vector<uint8_t> results;
+        EXPECT_EQ(dupBatch(views, results), 4); // abba, racecar, noon, aa
+        EXPECT_EQ(results, vector<uint8_t>({1, 0, 0, 1, 1, 1, 0, 0}));
+        EXPECT_EQ(isPalindromeBatch(views, results), 6);
+        EXPECT_EQ(results, vector<uint8_t>({1, 0, 1, 1, 1, 1, 0, 1}));
+        EXPECT_EQ(isMirrorStringBatch(views, results), 3);
+        EXPECT_EQ(results, vector<uint8_t>({1, 0, 0, 0, 1, 1, 0, 0}));
+    }
+
+    // Benchmark: map vs bitmap dup(), and scalar vs vectorized palindrome checks across lengths
+    TEST(AlgorithmTest, DupAndPalindromeBenchmark)
+    {
+        mt19937 engine(42);
+        for (size_t length : {8, 32, 128, 1024, 16384})
+        {
+            const size_t count = max<size_t>(64, (1 << 22) / length); // about 4 MiB of text per length
+            vector<string> strings(count);
+            for (auto &str : strings)
+            {
+                str.resize(length);
+                for (size_t i = 0; i < (length + 1) / 2; ++i)
+                {
+                    str[i] = str[length - 1 - i] = (char)('a' + engine() % 26);
+                }
+            }
+            vector<string_view> views(strings.begin(), strings.end());
+            vector<uint8_t> results;
+
+            size_t found = 0;
+            auto start = high_resolution_clock::now();
+            for (const auto &str : strings)
+            {
+                found += dupWithMap(str);
+            }
+            auto mapUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+            start = high_resolution_clock::now();
+            EXPECT_EQ(dupBatch(views, results), found);
+            auto bitmapUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+            found = 0;
+            start = high_resolution_clock::now();
+            for (const auto &str : strings)
+            {
+                found += isPalindromeScalar(str.data(), str.size());
+            }
+            auto scalarUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+            start = high_resolution_clock::now();
+            EXPECT_EQ(isPalindromeBatch(views, results), found);
+            auto vectorUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+            EXPECT_EQ(found, count);
+
+            cout << "Run time (" << count << " strings of " << length << " bytes): dup map " << mapUs << "us, bitmap "
+                 << bitmapUs << "us; palindrome scalar " << scalarUs << "us, vectorized " << vectorUs << "us" << endl;
+        }
+    }
 }
 // Add more tests as needed
 
@@ -0,0 +1,288 @@
+/*
+ * Author: Peter Arandorenko
+ * Date: January 26, 2024
+ */
+
+#ifndef CONFIG_SERVICE_H
+#define CONFIG_SERVICE_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "config_table.h"
+
+/**
+ * Hot-reloadable configuration. The current ConfigTable is published as an immutable snapshot
+ * behind an atomic pointer; a watcher thread reparses the file whenever inotify reports that it
+ * was written or replaced, then swaps the pointer.
+ *
+ * Readers never lock or copy: read() bumps a per-thread-stripe counter for the current epoch
+ * parity, checks the epoch did not move and loads the pointer; the guard drops the counter again.
+ * A reload publishes the new snapshot, flips the epoch and waits for the old parity's counters to
+ * drain before deleting the old snapshot (a grace period, as in SRCU). Reloads never block readers; a reader that holds a
+ * guard for a long time only delays the reload thread.
+ */
+class ConfigService
+{
+public:
+    struct Snapshot
+    {
+        ConfigTable table;
+        uint64_t version;
+    };
+
+    // RAII read-side critical section. The snapshot stays valid until the guard is destroyed.
+    class ReadGuard
+    {
+    public:
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+        ReadGuard(ReadGuard &&other) noexcept : counter(other.counter), snapshot(other.snapshot), service(other.service)
+        {
+            other.counter = nullptr;
+        }
+        ~ReadGuard()
+        {
+            if (counter)
+            {
+                counter->fetch_sub(1, std::memory_order_release);
+#ifndef NDEBUG
+                auto &held = heldGuards();
+                held.erase(std::find(held.begin(), held.end(), service));
+#endif
+            }
+        }
+
+        const ConfigTable &operator*() const { return snapshot->table; }
+        const ConfigTable *operator->() const { return &snapshot->table; }
+        uint64_t version() const { return snapshot->version; }
+
+    private:
+        friend class ConfigService;
+        ReadGuard(std::atomic<int64_t> *counter, const Snapshot *snapshot, const ConfigService *service)
+            : counter(counter), snapshot(snapshot), service(service)
+        {
+#ifndef NDEBUG
+            heldGuards().push_back(service);
+#endif
+        }
+
+        std::atomic<int64_t> *counter;
+        const Snapshot *snapshot;
+        const ConfigService *service;
+    };
+
+    // Load path now and, if watch is set, reload it on every change until destruction.
+    explicit ConfigService(std::string path, bool watch = true) : path(std::move(path))
+    {
+        current.store(new Snapshot{ConfigTable::loadCopy(this->path), 1});
+        if (watch)
+        {
+            startWatching();
+        }
+    }
+
+    ConfigService(const ConfigService &) = delete;
+    ConfigService &operator=(const ConfigService &) = delete;
+
+    ~ConfigService()
+    {
+        if (watcher.joinable())
+        {
+            const char stop = 0;
+            (void)!::write(stopPipe[1], &stop, 1);
+            watcher.join();
+        }
+        for (int fd : {stopPipe[0], stopPipe[1], inotifyFd})
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+        delete current.load();
+    }
+
+    ReadGuard read() const
+    {
+        std::atomic<int64_t> *counter;
+        for (;;)
+        {
+            const uint64_t observed = epoch.load();
+            counter = &stripes[stripeIndex()].readers[observed & 1];
+            counter->fetch_add(1);
+            // If the epoch is unchanged, any reload that has yet to flip it will wait for this
+            // counter, so the snapshot loaded below cannot be freed under us. Otherwise retry.
+            if (epoch.load() == observed)
+            {
+                break;
+            }
+            counter->fetch_sub(1);
+        }
+        return ReadGuard(counter, current.load(), this);
+    }
+
+    /**
+     * Parse the file and publish it. Returns false and keeps the current snapshot if the file
+     * cannot be read. Blocks until readers of the replaced snapshot are done, so the calling
+     * thread must not hold a ReadGuard of this service: it would wait for itself forever. Debug
+     * builds assert this.
+     */
+    bool reload()
+    {
+        assert(std::find(heldGuards().begin(), heldGuards().end(), this) == heldGuards().end() &&
+               "ConfigService::reload() called while holding one of its ReadGuards");
+        ConfigTable table = ConfigTable::loadCopy(path); // not mapped: the file is edited while snapshots live
+        if (!table.ok())
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(reloadMutex);
+        const Snapshot *old = current.load();
+        const uint64_t version = old->version + 1;
+        current.store(new Snapshot{std::move(table), version});
+        synchronize();
+        delete old;
+        {
+            std::lock_guard<std::mutex> versionLock(versionMutex);
+            publishedVersion = version;
+        }
+        published.notify_all();
+        return true;
+    }
+
+    // Through a guard: a bare load could race with reload() deleting the snapshot
+    uint64_t version() const { return read().version(); }
+
+    // Wait until a snapshot newer than version has been published. Returns false on timeout.
+    bool waitForNewerThan(uint64_t version, std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(versionMutex);
+        return published.wait_for(lock, timeout, [&]
+                                  { return publishedVersion > version; });
+    }
+
+    bool watching() const { return watcher.joinable(); }
+
+private:
+    static constexpr size_t kStripes = 64;
+
+    // Readers per epoch parity; one cache line per stripe so threads do not share counters
+    struct alignas(64) Stripe
+    {
+        std::array<std::atomic<int64_t>, 2> readers{};
+    };
+
+    // Services whose guards the calling thread holds, for the reload() deadlock check. Guards
+    // are expected to be released on the thread that took them.
+    static std::vector<const ConfigService *> &heldGuards()
+    {
+        thread_local std::vector<const ConfigService *> held;
+        return held;
+    }
+
+    static size_t stripeIndex()
+    {
+        thread_local const size_t index = std::hash<std::thread::id>{}(std::this_thread::get_id()) % kStripes;
+        return index;
+    }
+
+    // Wait for every reader that may still see the previous snapshot
+    void synchronize()
+    {
+        const uint64_t previous = epoch.fetch_add(1);
+        for (Stripe &stripe : stripes)
+        {
+            while (stripe.readers[previous & 1].load() != 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Watch the directory rather than the file so that editors replacing it by rename are seen.
+    // IN_CREATE is left out: a new file is still empty then, IN_CLOSE_WRITE follows once written.
+    void startWatching()
+    {
+        const size_t slash = path.find_last_of('/');
+        const std::string directory = slash == std::string::npos ? "." : path.substr(0, slash == 0 ? 1 : slash);
+        fileName = slash == std::string::npos ? path : path.substr(slash + 1);
+        inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0 || ::pipe(stopPipe) != 0)
+        {
+            return;
+        }
+        if (::inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+        {
+            return;
+        }
+        watcher = std::thread([this]
+                              { watch(); });
+    }
+
+    void watch()
+    {
+        alignas(inotify_event) char buffer[4096];
+        pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+        for (;;)
+        {
+            if (::poll(fds, 2, -1) < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return; // anything else will not go away by retrying; stop watching
+            }
+            if (fds[1].revents)
+            {
+                return;
+            }
+            bool changed = false;
+            ssize_t length;
+            while ((length = ::read(inotifyFd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *p = buffer; p < buffer + length;)
+                {
+                    const auto *event = reinterpret_cast<const inotify_event *>(p);
+                    changed |= event->len > 0 && fileName == event->name;
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+            if (changed)
+            {
+                reload();
+            }
+        }
+    }
+
+    const std::string path;
+    std::string fileName;
+    std::atomic<const Snapshot *> current{nullptr};
+    std::atomic<uint64_t> epoch{0};
+    mutable std::array<Stripe, kStripes> stripes;
+    std::mutex reloadMutex;
+    std::mutex versionMutex;
+    std::condition_variable published;
+    uint64_t publishedVersion = 1;
+    int inotifyFd = -1;
+    int stopPipe[2] = {-1, -1};
+    std::thread watcher;
+};
+
+#endif // CONFIG_SERVICE_H
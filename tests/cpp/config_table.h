@@ -0,0 +1,286 @@
+/*
+ * Author: Peter Arandorenko
+ * Date: January 26, 2024
+ */
+
+#ifndef CONFIG_TABLE_H
+#define CONFIG_TABLE_H
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "file_reader.h"
+
+/**
+ * Immutable key=value configuration parsed straight out of a memory-mapped file.
+ *
+ * Keys and values are string_views into the mapping, which the table owns, so parsing allocates
+ * only the flat entry vector and an open-addressing index sized from the line count, never per
+ * line. When a key repeats, the last value wins. Integer values are parsed once at load time.
+ * Lines without '=' are skipped and keys and values are trimmed of spaces, tabs and line endings,
+ * as readConfigFile did.
+ */
+class ConfigTable
+{
+public:
+    ConfigTable() = default;
+
+    /**
+     * Parse the file at path. An unreadable file gives an empty table with ok() false.
+     * The table reads from the mapping, so the file must not be truncated or rewritten in place
+     * while the table is alive (accessing it would raise SIGBUS); use loadCopy() for such files.
+     */
+    static ConfigTable load(const std::string &path)
+    {
+        ConfigTable table;
+        table.file = MappedFile(path);
+        table.loaded = table.file.ok();
+        table.tokenize(std::string_view(table.file.data(), table.file.size()));
+        return table;
+    }
+
+    // Like load(), but read() the file into one owned buffer so later edits cannot affect the table.
+    static ConfigTable loadCopy(const std::string &path)
+    {
+        ConfigTable table;
+        FileDescriptor file(::open(path.c_str(), O_RDONLY));
+        struct stat info;
+        if (!file || ::fstat(file.get(), &info) != 0)
+        {
+            return table;
+        }
+        table.copy.resize(static_cast<size_t>(info.st_size));
+        size_t filled = 0;
+        for (;;)
+        {
+            if (filled == table.copy.size())
+            {
+                table.copy.resize(table.copy.size() * 2 + 4096); // the file grew since fstat
+            }
+            const ssize_t bytesRead = ::read(file.get(), table.copy.data() + filled, table.copy.size() - filled);
+            if (bytesRead < 0)
+            {
+                return ConfigTable();
+            }
+            if (bytesRead == 0)
+            {
+                break;
+            }
+            filled += static_cast<size_t>(bytesRead);
+        }
+        table.copy.resize(filled);
+        table.loaded = true;
+        table.tokenize(std::string_view(table.copy.data(), table.copy.size()));
+        return table;
+    }
+
+    // Parse text that must outlive the table, e.g. a string literal.
+    static ConfigTable fromText(std::string_view text)
+    {
+        ConfigTable table;
+        table.loaded = true;
+        table.tokenize(text);
+        return table;
+    }
+
+    bool ok() const { return loaded; }
+    size_t size() const { return entries.size(); }
+    bool contains(std::string_view key) const { return find(key) != nullptr; }
+
+    std::optional<std::string_view> get(std::string_view key) const
+    {
+        const Entry *entry = find(key);
+        if (!entry)
+        {
+            return std::nullopt;
+        }
+        return entry->value;
+    }
+
+    // The value as an integer if the whole value is one, parsed at load time
+    std::optional<int64_t> getInt(std::string_view key) const
+    {
+        const Entry *entry = find(key);
+        if (!entry || !entry->isInt)
+        {
+            return std::nullopt;
+        }
+        return entry->intValue;
+    }
+
+    std::optional<double> getDouble(std::string_view key) const
+    {
+        const Entry *entry = find(key);
+        double value;
+        if (!entry || !parseWhole(entry->value, value))
+        {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    // true/false, yes/no, on/off or 1/0
+    std::optional<bool> getBool(std::string_view key) const
+    {
+        const Entry *entry = find(key);
+        if (!entry)
+        {
+            return std::nullopt;
+        }
+        const std::string_view value = entry->value;
+        if (value == "true" || value == "yes" || value == "on" || value == "1")
+        {
+            return true;
+        }
+        if (value == "false" || value == "no" || value == "off" || value == "0")
+        {
+            return false;
+        }
+        return std::nullopt;
+    }
+
+    // Visit entries in file order (of each key's first occurrence) as fn(key, value)
+    template <typename F>
+    void forEach(F &&fn) const
+    {
+        for (const Entry &entry : entries)
+        {
+            fn(entry.key, entry.value);
+        }
+    }
+
+private:
+    struct Entry
+    {
+        std::string_view key;
+        std::string_view value;
+        int64_t intValue = 0;
+        bool isInt = false;
+    };
+
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+    // FNV-1a
+    static uint64_t hashKey(std::string_view key)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : key)
+        {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // Index slot holding key, or the empty slot where it would go
+    size_t slotFor(std::string_view key) const
+    {
+        const size_t mask = index.size() - 1;
+        for (size_t slot = hashKey(key) & mask;; slot = (slot + 1) & mask)
+        {
+            if (index[slot] == kEmpty || entries[index[slot]].key == key)
+            {
+                return slot;
+            }
+        }
+    }
+
+    template <typename T>
+    static bool parseWhole(std::string_view text, T &value)
+    {
+        const char *end = text.data() + text.size();
+        const auto result = std::from_chars(text.data(), end, value);
+        return !text.empty() && result.ec == std::errc() && result.ptr == end;
+    }
+
+    static std::string_view trim(std::string_view text)
+    {
+        const auto isSpace = [](char c)
+        { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+        size_t begin = 0;
+        size_t end = text.size();
+        while (begin < end && isSpace(text[begin]))
+        {
+            ++begin;
+        }
+        while (end > begin && isSpace(text[end - 1]))
+        {
+            --end;
+        }
+        return text.substr(begin, end - begin);
+    }
+
+    void tokenize(std::string_view text)
+    {
+        // One entry per line at most; counting lines first avoids regrowing the vector. A missing
+        // or empty file has no data pointer at all, and memchr must not be handed a null one.
+        size_t lines = 1;
+        for (const char *p = text.data(), *end = p + text.size();
+             !text.empty() && (p = static_cast<const char *>(std::memchr(p, '\n', end - p))) != nullptr; ++p)
+        {
+            ++lines;
+        }
+        entries.reserve(lines);
+        size_t capacity = 2;
+        while (capacity < 2 * lines)
+        {
+            capacity *= 2;
+        }
+        index.assign(capacity, kEmpty);
+
+        size_t position = 0;
+        while (position < text.size())
+        {
+            size_t lineEnd = text.find('\n', position);
+            if (lineEnd == std::string_view::npos)
+            {
+                lineEnd = text.size();
+            }
+            const std::string_view line = text.substr(position, lineEnd - position);
+            position = lineEnd + 1;
+
+            const size_t delimiter = line.find('=');
+            if (delimiter == std::string_view::npos)
+            {
+                continue;
+            }
+            Entry entry;
+            entry.key = trim(line.substr(0, delimiter));
+            entry.value = trim(line.substr(delimiter + 1));
+            entry.isInt = parseWhole(entry.value, entry.intValue);
+
+            const size_t slot = slotFor(entry.key);
+            if (index[slot] == kEmpty)
+            {
+                index[slot] = static_cast<uint32_t>(entries.size());
+                entries.push_back(entry);
+            }
+            else
+            {
+                entries[index[slot]] = entry;
+            }
+        }
+    }
+
+    const Entry *find(std::string_view key) const
+    {
+        if (index.empty())
+        {
+            return nullptr;
+        }
+        const uint32_t position = index[slotFor(key)];
+        return position == kEmpty ? nullptr : &entries[position];
+    }
+
+    MappedFile file;
+    std::vector<char> copy; // loadCopy() text; a vector keeps its buffer when moved, unlike a short string
+    std::vector<Entry> entries;
+    std::vector<uint32_t> index; // power-of-two open-addressing table of positions in entries
+    bool loaded = false;
+};
+
+#endif // CONFIG_TABLE_H
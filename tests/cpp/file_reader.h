@@ -0,0 +1,865 @@
+/*
+ * Author: Peter Arandorenko
+ * Date: January 26, 2024
+ */
+
+#ifndef FILE_READER_H
+#define FILE_READER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/**
+ * Consumer of file data. consume() receives a view that is only valid for the duration of the
+ * call: with the memory-mapped reader it points straight into the page cache, so nothing is
+ * copied unless the sink decides to.
+ */
+class ChunkSink
+{
+public:
+    virtual ~ChunkSink() = default;
+    virtual void consume(const char *data, size_t size) = 0;
+};
+
+// Sink that writes every chunk to a stream, e.g. std::cout.
+class StreamSink : public ChunkSink
+{
+public:
+    explicit StreamSink(std::ostream &out) : out(out) {}
+    void consume(const char *data, size_t size) override { out.write(data, static_cast<std::streamsize>(size)); }
+
+private:
+    std::ostream &out;
+};
+
+/**
+ * Progress logger that writes at most one line per interval, plus a final line from finish().
+ * Lines end in '\n' rather than std::endl so that logging never forces a flush per chunk.
+ */
+class ProgressLog
+{
+public:
+    ProgressLog(std::ostream &out, std::chrono::milliseconds interval) : out(out), interval(interval) {}
+
+    void update(uint64_t totalBytes)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (lines > 0 && now - lastLine < interval)
+        {
+            return;
+        }
+        write(totalBytes);
+        lastLine = now;
+    }
+
+    void finish(uint64_t totalBytes)
+    {
+        write(totalBytes);
+        out.flush();
+    }
+
+    size_t lineCount() const { return lines; }
+
+private:
+    void write(uint64_t totalBytes)
+    {
+        out << "Total characters read so far: " << totalBytes << '\n';
+        ++lines;
+    }
+
+    std::ostream &out;
+    std::chrono::milliseconds interval;
+    std::chrono::steady_clock::time_point lastLine;
+    size_t lines = 0;
+};
+
+enum class ReadMode
+{
+    Auto,     // memory-map regular files, fall back to read() otherwise
+    Mapped,   // mmap the whole file and hand out views into the mapping (empty files and pipes are read)
+    Buffered, // read() into one large reusable buffer
+    Uring,    // keep queueDepth reads in flight with io_uring, pread() when io_uring is unavailable
+    Pread,    // the Uring fallback on its own: one pread() per chunk
+};
+
+struct ReadOptions
+{
+    size_t chunkSize = 1 << 20;
+    ReadMode mode = ReadMode::Auto;
+    unsigned queueDepth = 8; // Uring only: chunks read ahead of the sink
+};
+
+// What a read cost, for benchmarks. syscalls counts read()/pread()/io_uring_enter() calls.
+struct ReadStats
+{
+    uint64_t syscalls = 0;
+    bool usedUring = false;
+    bool registeredBuffers = false;
+};
+
+// Closes a file descriptor when it goes out of scope.
+class FileDescriptor
+{
+public:
+    explicit FileDescriptor(int fd) : fd(fd) {}
+    ~FileDescriptor()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+    FileDescriptor(const FileDescriptor &) = delete;
+    FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+    int get() const { return fd; }
+    explicit operator bool() const { return fd >= 0; }
+
+private:
+    int fd;
+};
+
+/**
+ * Read-only mapping of a whole file, unmapped on destruction. Empty files map to an empty view;
+ * ok() is false if the file could not be opened or mapped.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &path)
+    {
+        FileDescriptor file(::open(path.c_str(), O_RDONLY));
+        struct stat info;
+        if (!file || ::fstat(file.get(), &info) != 0 || !S_ISREG(info.st_mode))
+        {
+            return;
+        }
+        opened = true;
+        length = static_cast<size_t>(info.st_size);
+        if (length == 0)
+        {
+            return;
+        }
+        void *mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file.get(), 0);
+        if (mapping == MAP_FAILED)
+        {
+            opened = false;
+            length = 0;
+            return;
+        }
+        ::madvise(mapping, length, MADV_SEQUENTIAL);
+        bytes = static_cast<const char *>(mapping);
+    }
+    ~MappedFile() { unmap(); }
+
+    MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            unmap();
+            bytes = std::exchange(other.bytes, nullptr);
+            length = std::exchange(other.length, 0);
+            opened = std::exchange(other.opened, false);
+        }
+        return *this;
+    }
+
+    bool ok() const { return opened; }
+    const char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    void unmap()
+    {
+        if (bytes)
+        {
+            ::munmap(const_cast<char *>(bytes), length);
+        }
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const char *bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+};
+
+/**
+ * Minimal io_uring instance driven through the raw syscalls (no liburing). One thread owns it:
+ * it fills submission entries, calls enter() and reaps completions.
+ */
+class IoUring
+{
+public:
+    explicit IoUring(unsigned entries)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+        {
+            return;
+        }
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap)
+        {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+        sqRing = map(sqRingSize, IORING_OFF_SQ_RING);
+        cqRing = singleMap ? sqRing : map(cqRingSize, IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(map(sqesSize, IORING_OFF_SQES));
+        if (!sqRing || !cqRing || !sqes)
+        {
+            release();
+            return;
+        }
+        char *sq = static_cast<char *>(sqRing);
+        char *cq = static_cast<char *>(cqRing);
+        sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        sqEntries = params.sq_entries;
+        cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        localTail = *sqTail;
+    }
+
+    ~IoUring() { release(); }
+    IoUring(const IoUring &) = delete;
+    IoUring &operator=(const IoUring &) = delete;
+
+    explicit operator bool() const { return fd >= 0; }
+
+    // Pin buffers so reads can use IORING_OP_READ_FIXED. Fails e.g. under a low RLIMIT_MEMLOCK.
+    bool registerBuffers(const iovec *buffers, unsigned count)
+    {
+        return ::syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+    }
+
+    // Next free submission entry, zeroed, or nullptr if the submission queue is full.
+    io_uring_sqe *nextSqe()
+    {
+        const unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (localTail - head >= sqEntries)
+        {
+            return nullptr;
+        }
+        const unsigned index = localTail & sqMask;
+        io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqArray[index] = index;
+        ++localTail;
+        ++unsubmitted;
+        return sqe;
+    }
+
+    // Publish queued entries and wait for at least waitFor completions. Returns false on error.
+    bool enter(unsigned waitFor)
+    {
+        __atomic_store_n(sqTail, localTail, __ATOMIC_RELEASE);
+        for (;;)
+        {
+            const long submitted = ::syscall(__NR_io_uring_enter, fd, unsubmitted, waitFor,
+                                             waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (submitted >= 0)
+            {
+                unsubmitted -= static_cast<unsigned>(submitted);
+                return true;
+            }
+            if (errno != EINTR)
+            {
+                return false;
+            }
+        }
+    }
+
+    // Pop one completion if there is one.
+    bool nextCqe(io_uring_cqe &cqe)
+    {
+        const unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+        {
+            return false;
+        }
+        cqe = cqes[head & cqMask];
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+private:
+    void *map(size_t size, off_t offset)
+    {
+        void *ring = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return ring == MAP_FAILED ? nullptr : ring;
+    }
+
+    void release()
+    {
+        if (sqes)
+        {
+            ::munmap(sqes, sqesSize);
+        }
+        if (cqRing && cqRing != sqRing)
+        {
+            ::munmap(cqRing, cqRingSize);
+        }
+        if (sqRing)
+        {
+            ::munmap(sqRing, sqRingSize);
+        }
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+        sqes = nullptr;
+        sqRing = cqRing = nullptr;
+        fd = -1;
+    }
+
+    int fd = -1;
+    void *sqRing = nullptr;
+    void *cqRing = nullptr;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+    unsigned *sqHead = nullptr, *sqTail = nullptr, *sqArray = nullptr;
+    unsigned *cqHead = nullptr, *cqTail = nullptr;
+    unsigned sqMask = 0, cqMask = 0, sqEntries = 0;
+    io_uring_cqe *cqes = nullptr;
+    unsigned localTail = 0;
+    unsigned unsubmitted = 0;
+};
+
+// One pread() per chunk, in order. Returns the bytes delivered or -1.
+inline int64_t preadFile(int fd, uint64_t length, ChunkSink &sink, ProgressLog &log, size_t chunkSize, ReadStats &stats)
+{
+    std::vector<char> buffer(chunkSize);
+    uint64_t total = 0;
+    while (total < length)
+    {
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(chunkSize, length - total));
+        size_t filled = 0;
+        while (filled < want)
+        {
+            const ssize_t bytesRead = ::pread(fd, buffer.data() + filled, want - filled, static_cast<off_t>(total + filled));
+            ++stats.syscalls;
+            if (bytesRead < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return -1;
+            }
+            if (bytesRead == 0)
+            {
+                break; // the file shrank
+            }
+            filled += static_cast<size_t>(bytesRead);
+        }
+        if (filled == 0)
+        {
+            break;
+        }
+        sink.consume(buffer.data(), filled);
+        total += filled;
+        log.update(total);
+        if (filled < want)
+        {
+            break;
+        }
+    }
+    log.finish(total);
+    return static_cast<int64_t>(total);
+}
+
+/**
+ * Read length bytes of fd with up to queueDepth chunk reads in flight on an io_uring, delivering
+ * chunks to sink in file order as soon as the oldest one completes. Each in-flight chunk owns one
+ * buffer; the buffers are registered with the ring when the kernel allows it. Returns the bytes
+ * delivered, -1 on a read error, or -2 if no ring could be created (nothing has been consumed).
+ */
+inline int64_t uringFile(int fd, uint64_t length, ChunkSink &sink, ProgressLog &log, size_t chunkSize, unsigned queueDepth,
+                         ReadStats &stats)
+{
+    const uint64_t chunkCount = (length + chunkSize - 1) / chunkSize;
+    const unsigned depth = static_cast<unsigned>(std::max<uint64_t>(1, std::min<uint64_t>(std::max(1u, queueDepth), chunkCount)));
+    IoUring ring(depth);
+    if (!ring)
+    {
+        return -2;
+    }
+    stats.usedUring = true;
+
+    struct Slot
+    {
+        uint64_t offset = 0;
+        size_t length = 0;
+        size_t filled = 0;
+        bool done = false;
+        iovec io; // the unfilled part of the buffer, for IORING_OP_READV
+    };
+    std::vector<char> storage(static_cast<size_t>(depth) * chunkSize);
+    std::vector<Slot> slots(depth);
+    std::vector<iovec> buffers(depth);
+    for (unsigned i = 0; i < depth; ++i)
+    {
+        buffers[i].iov_base = storage.data() + static_cast<size_t>(i) * chunkSize;
+        buffers[i].iov_len = chunkSize;
+    }
+    const bool fixed = ring.registerBuffers(buffers.data(), depth);
+    stats.registeredBuffers = fixed;
+
+    unsigned inFlight = 0;
+    auto submit = [&](unsigned index)
+    {
+        Slot &slot = slots[index];
+        char *target = static_cast<char *>(buffers[index].iov_base) + slot.filled;
+        io_uring_sqe *sqe = ring.nextSqe(); // never null: at most depth reads are queued
+        sqe->fd = fd;
+        sqe->off = slot.offset + slot.filled;
+        sqe->user_data = index;
+        if (fixed)
+        {
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(target);
+            sqe->len = static_cast<uint32_t>(slot.length - slot.filled);
+            sqe->buf_index = static_cast<uint16_t>(index);
+        }
+        else
+        {
+            slot.io.iov_base = target;
+            slot.io.iov_len = slot.length - slot.filled;
+            sqe->opcode = IORING_OP_READV;
+            sqe->addr = reinterpret_cast<uint64_t>(&slot.io);
+            sqe->len = 1;
+        }
+        ++inFlight;
+    };
+    auto schedule = [&](uint64_t chunk)
+    {
+        const unsigned index = static_cast<unsigned>(chunk % depth);
+        Slot &slot = slots[index];
+        slot.offset = chunk * chunkSize;
+        slot.length = static_cast<size_t>(std::min<uint64_t>(chunkSize, length - slot.offset));
+        slot.filled = 0;
+        slot.done = false;
+        submit(index);
+    };
+
+    for (uint64_t chunk = 0; chunk < depth; ++chunk)
+    {
+        schedule(chunk);
+    }
+    uint64_t total = 0;
+    uint64_t nextChunk = 0;
+    bool failed = false;
+    bool truncated = false;
+    while (nextChunk < chunkCount && !failed && !truncated)
+    {
+        ++stats.syscalls;
+        if (!ring.enter(1))
+        {
+            failed = true;
+            break;
+        }
+        io_uring_cqe cqe;
+        while (ring.nextCqe(cqe))
+        {
+            --inFlight;
+            Slot &slot = slots[cqe.user_data];
+            if (cqe.res < 0)
+            {
+                if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+                {
+                    submit(static_cast<unsigned>(cqe.user_data));
+                    continue;
+                }
+                failed = true;
+                continue;
+            }
+            slot.filled += static_cast<size_t>(cqe.res);
+            if (cqe.res > 0 && slot.filled < slot.length)
+            {
+                submit(static_cast<unsigned>(cqe.user_data)); // short read: fetch the rest
+                continue;
+            }
+            slot.done = true; // complete, or cut short because the file shrank
+        }
+        // Hand over every chunk that is ready in order and reuse its buffer for a later chunk
+        while (!failed && !truncated && nextChunk < chunkCount)
+        {
+            const unsigned index = static_cast<unsigned>(nextChunk % depth);
+            Slot &slot = slots[index];
+            if (!slot.done)
+            {
+                break;
+            }
+            if (slot.filled > 0)
+            {
+                sink.consume(static_cast<const char *>(buffers[index].iov_base), slot.filled);
+                total += slot.filled;
+                log.update(total);
+            }
+            truncated = slot.filled < slot.length;
+            if (!truncated && nextChunk + depth < chunkCount)
+            {
+                schedule(nextChunk + depth);
+            }
+            ++nextChunk;
+        }
+    }
+    // The kernel may still be writing into the buffers; wait for every read before freeing them
+    io_uring_cqe cqe;
+    while (inFlight > 0 && ring.enter(1))
+    {
+        while (ring.nextCqe(cqe))
+        {
+            --inFlight;
+        }
+    }
+    if (failed)
+    {
+        return -1;
+    }
+    log.finish(total);
+    return static_cast<int64_t>(total);
+}
+
+/**
+ * Stream the file at path to sink in chunks of options.chunkSize bytes, logging progress to log.
+ * Returns the number of bytes delivered, or -1 if the file could not be opened or read.
+ */
+inline int64_t streamFile(const std::string &path, ChunkSink &sink, ProgressLog &log, const ReadOptions &options = ReadOptions(),
+                          ReadStats *stats = nullptr)
+{
+    const size_t chunkSize = options.chunkSize == 0 ? 1 : options.chunkSize;
+    FileDescriptor file(::open(path.c_str(), O_RDONLY));
+    if (!file)
+    {
+        return -1;
+    }
+    struct stat info;
+    if (::fstat(file.get(), &info) != 0)
+    {
+        return -1;
+    }
+
+    ReadStats localStats;
+    ReadStats &counters = stats ? *stats : localStats;
+    uint64_t total = 0;
+    if ((options.mode == ReadMode::Uring || options.mode == ReadMode::Pread) && S_ISREG(info.st_mode))
+    {
+        const uint64_t length = static_cast<uint64_t>(info.st_size);
+        if (options.mode == ReadMode::Uring && length > 0)
+        {
+            const int64_t result = uringFile(file.get(), length, sink, log, chunkSize, options.queueDepth, counters);
+            if (result != -2)
+            {
+                return result;
+            }
+        }
+        return preadFile(file.get(), length, sink, log, chunkSize, counters);
+    }
+    const bool mappable = S_ISREG(info.st_mode) && info.st_size > 0;
+    if ((options.mode == ReadMode::Auto || options.mode == ReadMode::Mapped) && mappable)
+    {
+        const size_t length = static_cast<size_t>(info.st_size);
+        void *mapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file.get(), 0);
+        if (mapping != MAP_FAILED)
+        {
+            ::madvise(mapping, length, MADV_SEQUENTIAL);
+            const char *data = static_cast<const char *>(mapping);
+            for (size_t offset = 0; offset < length; offset += chunkSize)
+            {
+                const size_t size = std::min(chunkSize, length - offset);
+                sink.consume(data + offset, size);
+                total += size;
+                log.update(total);
+            }
+            ::munmap(mapping, length);
+            log.finish(total);
+            return static_cast<int64_t>(total);
+        }
+        if (options.mode == ReadMode::Mapped)
+        {
+            return -1;
+        }
+    }
+    std::vector<char> buffer(chunkSize);
+    for (;;)
+    {
+        // Fill the whole buffer so that sinks see full chunks even if read() returns short
+        size_t filled = 0;
+        while (filled < chunkSize)
+        {
+            const ssize_t bytesRead = ::read(file.get(), buffer.data() + filled, chunkSize - filled);
+            ++counters.syscalls;
+            if (bytesRead < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return -1;
+            }
+            if (bytesRead == 0)
+            {
+                break;
+            }
+            filled += static_cast<size_t>(bytesRead);
+        }
+        if (filled == 0)
+        {
+            break;
+        }
+        sink.consume(buffer.data(), filled);
+        total += filled;
+        log.update(total);
+        if (filled < chunkSize)
+        {
+            break;
+        }
+    }
+    log.finish(total);
+    return static_cast<int64_t>(total);
+}
+
+/**
+ * Blocking FIFO with a fixed capacity. push() waits while the queue is full, pop() waits while it is
+ * empty and returns false once the queue is closed and drained.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+    void push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notFull.wait(lock, [this]
+                     { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        lock.unlock();
+        notEmpty.notify_one();
+    }
+
+    bool pop(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        notEmpty.wait(lock, [this]
+                      { return closed || !items.empty(); });
+        if (items.empty())
+        {
+            return false;
+        }
+        item = std::move(items.front());
+        items.pop_front();
+        lock.unlock();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Wake consumers; pop() fails once the remaining items are gone.
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        notEmpty.notify_all();
+    }
+
+private:
+    const size_t capacity;
+    std::deque<T> items;
+    std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    bool closed = false;
+};
+
+struct PipelineOptions
+{
+    size_t chunkSize = 1 << 20;
+    size_t bufferCount = 4; // buffers shared by all stages; bounds memory and read-ahead
+};
+
+/**
+ * Stream the file at path through stages with the reading overlapped with the consuming.
+ *
+ * The calling thread is the reader: it takes a free buffer from the pool, fills it with read() and
+ * hands it to the first stage. Every stage runs on its own thread and sees each chunk in file
+ * order; the last stage returns the buffer to the pool, so at most bufferCount chunks are in
+ * flight. Progress is logged by the last stage as chunks leave the pipeline.
+ *
+ * Returns the number of bytes delivered, or -1 if the file could not be opened or read. An
+ * exception thrown by a stage stops the reader and is rethrown here once all threads have joined.
+ */
+inline int64_t pipelineFile(const std::string &path, const std::vector<ChunkSink *> &stages, ProgressLog &log,
+                            const PipelineOptions &options = PipelineOptions())
+{
+    FileDescriptor file(::open(path.c_str(), O_RDONLY));
+    if (!file)
+    {
+        return -1;
+    }
+    if (stages.empty())
+    {
+        return 0;
+    }
+    const size_t chunkSize = options.chunkSize == 0 ? 1 : options.chunkSize;
+    const size_t bufferCount = std::max<size_t>(1, options.bufferCount);
+
+    struct Chunk
+    {
+        std::vector<char> data;
+        size_t size = 0;
+    };
+    BoundedQueue<Chunk> freeBuffers(bufferCount);
+    for (size_t i = 0; i < bufferCount; ++i)
+    {
+        freeBuffers.push(Chunk{std::vector<char>(chunkSize), 0});
+    }
+    // queues[i] feeds stage i
+    std::vector<std::unique_ptr<BoundedQueue<Chunk>>> queues;
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        queues.push_back(std::make_unique<BoundedQueue<Chunk>>(bufferCount));
+    }
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    std::atomic<bool> failed{false};
+    uint64_t delivered = 0; // only touched by the last stage until it is joined
+
+    std::vector<std::thread> workers;
+    workers.reserve(stages.size());
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+        workers.emplace_back([&, i]
+                             {
+            const bool last = i + 1 == stages.size();
+            Chunk chunk;
+            while (queues[i]->pop(chunk))
+            {
+                // After a failure keep draining so buffers still reach the pool and no thread blocks
+                if (!failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        stages[i]->consume(chunk.data.data(), chunk.size);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (!error)
+                        {
+                            error = std::current_exception();
+                        }
+                        failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+                if (last)
+                {
+                    delivered += chunk.size;
+                    log.update(delivered);
+                    freeBuffers.push(std::move(chunk));
+                }
+                else
+                {
+                    queues[i + 1]->push(std::move(chunk));
+                }
+            }
+            if (!last)
+            {
+                queues[i + 1]->close();
+            } });
+    }
+
+    bool readError = false;
+    while (!failed.load(std::memory_order_relaxed))
+    {
+        Chunk chunk;
+        freeBuffers.pop(chunk);
+        // Fill the whole buffer so that stages see full chunks even if read() returns short
+        size_t filled = 0;
+        while (filled < chunkSize)
+        {
+            const ssize_t bytesRead = ::read(file.get(), chunk.data.data() + filled, chunkSize - filled);
+            if (bytesRead < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                readError = true;
+                break;
+            }
+            if (bytesRead == 0)
+            {
+                break;
+            }
+            filled += static_cast<size_t>(bytesRead);
+        }
+        if (readError || filled == 0)
+        {
+            break;
+        }
+        chunk.size = filled;
+        queues[0]->push(std::move(chunk));
+        if (filled < chunkSize)
+        {
+            break;
+        }
+    }
+    queues[0]->close();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+    if (readError)
+    {
+        return -1;
+    }
+    log.finish(delivered);
+    return static_cast<int64_t>(delivered);
+}
+
+#endif // FILE_READER_H
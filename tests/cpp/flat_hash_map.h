@@ -0,0 +1,434 @@
+/*
+ * Author: Peter Arandorenko
+ * Date: January 26, 2024
+ */
+
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Open-addressing hash map in the style of a Swiss table.
+ *
+ * Entries live in one flat slot array, so inserting never allocates a node. Every slot has a
+ * control byte: empty, deleted, or the low 7 bits of the key's hash. Lookups scan the control
+ * bytes 16 at a time (one SSE2 compare per group) and only compare keys whose 7 bits match, so a
+ * miss rarely touches the slots at all. Probing moves group by group from the hash position.
+ * The table grows at 7/8 load and capacity is a power of two.
+ *
+ * Unlike std::unordered_map, references and iterators are invalidated by any insert that grows the
+ * table, and by rehash() and reserve().
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename Eq = std::equal_to<K>>
+class FlatHashMap
+{
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+
+    template <bool Const>
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const value_type &, value_type &>;
+        using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+
+        Iterator() = default;
+        // iterator converts to const_iterator
+        template <bool WasConst, typename = std::enable_if_t<Const && !WasConst>>
+        Iterator(const Iterator<WasConst> &other) : map(other.map), index(other.index) {}
+
+        reference operator*() const { return map->slots[index]; }
+        pointer operator->() const { return &map->slots[index]; }
+        Iterator &operator++()
+        {
+            index = map->nextFull(index + 1);
+            return *this;
+        }
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const Iterator &other) const { return index == other.index; }
+        bool operator!=(const Iterator &other) const { return index != other.index; }
+
+    private:
+        friend class FlatHashMap;
+        template <bool>
+        friend class Iterator;
+        using Map = std::conditional_t<Const, const FlatHashMap, FlatHashMap>;
+        Iterator(Map *map, size_t index) : map(map), index(index) {}
+
+        Map *map = nullptr;
+        size_t index = 0;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashMap() = default;
+
+    FlatHashMap(std::initializer_list<value_type> values)
+    {
+        reserve(values.size());
+        for (const auto &value : values)
+        {
+            try_emplace(value.first, value.second);
+        }
+    }
+
+    FlatHashMap(const FlatHashMap &other)
+    {
+        reserve(other.size());
+        for (const auto &value : other)
+        {
+            try_emplace(value.first, value.second);
+        }
+    }
+
+    FlatHashMap(FlatHashMap &&other) noexcept { swap(other); }
+
+    FlatHashMap &operator=(FlatHashMap other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~FlatHashMap() { destroy(); }
+
+    void swap(FlatHashMap &other) noexcept
+    {
+        std::swap(control, other.control);
+        std::swap(slots, other.slots);
+        std::swap(slotCount, other.slotCount);
+        std::swap(used, other.used);
+        std::swap(tombstones, other.tombstones);
+    }
+
+    iterator begin() { return iterator(this, nextFull(0)); }
+    iterator end() { return iterator(this, slotCount); }
+    const_iterator begin() const { return const_iterator(this, nextFull(0)); }
+    const_iterator end() const { return const_iterator(this, slotCount); }
+
+    size_t size() const { return used; }
+    bool empty() const { return used == 0; }
+    size_t capacity() const { return slotCount; }
+
+    // Make room for n entries without growing again
+    void reserve(size_t n)
+    {
+        size_t wanted = kGroupWidth;
+        while (wanted * 7 / 8 < n)
+        {
+            wanted *= 2;
+        }
+        if (wanted > slotCount)
+        {
+            rehash(wanted);
+        }
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i < slotCount; ++i)
+        {
+            if (isFull(control[i]))
+            {
+                slots[i].~value_type();
+            }
+        }
+        if (control)
+        {
+            std::memset(control, kEmpty, slotCount + kGroupWidth);
+        }
+        used = 0;
+        tombstones = 0;
+    }
+
+    /**
+     * Insert key with a value built from args unless key is present, with a single probe: the
+     * search for key remembers the first free slot it passes. Returns the entry and whether it
+     * was inserted; args are untouched when it was not.
+     */
+    template <typename KeyArg, typename... Args>
+    std::pair<iterator, bool> try_emplace(KeyArg &&key, Args &&...args)
+    {
+        if (used + tombstones + 1 > slotCount * 7 / 8)
+        {
+            // Mostly tombstones: clean up in place, otherwise double
+            rehash(used * 2 < slotCount * 7 / 8 && slotCount > 0 ? slotCount : std::max<size_t>(kGroupWidth, slotCount * 2));
+        }
+        const size_t hash = mix(Hash{}(key));
+        const int8_t tag = static_cast<int8_t>(hash & 0x7F);
+        size_t freeSlot = SIZE_MAX;
+        for (size_t position = (hash >> 7) & mask();; position = (position + kGroupWidth) & mask())
+        {
+            for (uint32_t match = matchTag(position, tag); match; match &= match - 1)
+            {
+                const size_t index = (position + __builtin_ctz(match)) & mask();
+                if (Eq{}(slots[index].first, key))
+                {
+                    return {iterator(this, index), false};
+                }
+            }
+            if (freeSlot == SIZE_MAX)
+            {
+                const uint32_t free = matchFree(position);
+                if (free)
+                {
+                    freeSlot = (position + __builtin_ctz(free)) & mask();
+                }
+            }
+            if (matchEmpty(position))
+            {
+                break; // key would have been placed before the first empty slot
+            }
+        }
+        if (control[freeSlot] == kDeleted)
+        {
+            --tombstones;
+        }
+        new (&slots[freeSlot]) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<KeyArg>(key)),
+                                          std::forward_as_tuple(std::forward<Args>(args)...));
+        setControl(freeSlot, tag);
+        ++used;
+        return {iterator(this, freeSlot), true};
+    }
+
+    template <typename KeyArg, typename ValueArg>
+    std::pair<iterator, bool> insert_or_assign(KeyArg &&key, ValueArg &&value)
+    {
+        auto result = try_emplace(std::forward<KeyArg>(key), std::forward<ValueArg>(value));
+        if (!result.second)
+        {
+            result.first->second = std::forward<ValueArg>(value);
+        }
+        return result;
+    }
+
+    V &operator[](const K &key) { return try_emplace(key).first->second; }
+    V &operator[](K &&key) { return try_emplace(std::move(key)).first->second; }
+
+    V &at(const K &key)
+    {
+        auto it = find(key);
+        if (it == end())
+        {
+            throw std::out_of_range("FlatHashMap::at: key not found");
+        }
+        return it->second;
+    }
+    const V &at(const K &key) const { return const_cast<FlatHashMap *>(this)->at(key); }
+
+    iterator find(const K &key) { return iterator(this, locate(key)); }
+    const_iterator find(const K &key) const { return const_iterator(this, locate(key)); }
+    bool contains(const K &key) const { return locate(key) != slotCount; }
+    size_t count(const K &key) const { return contains(key) ? 1 : 0; }
+
+    // Remove key if present. The slot becomes a tombstone so later probes keep going past it.
+    size_t erase(const K &key)
+    {
+        const size_t index = locate(key);
+        if (index == slotCount)
+        {
+            return 0;
+        }
+        slots[index].~value_type();
+        setControl(index, kDeleted);
+        --used;
+        ++tombstones;
+        return 1;
+    }
+
+    // Rebuild with at least newCapacity slots (a power of two), dropping tombstones.
+    void rehash(size_t newCapacity)
+    {
+        size_t capacity = kGroupWidth;
+        while (capacity < newCapacity || capacity * 7 / 8 < used)
+        {
+            capacity *= 2;
+        }
+        FlatHashMap next;
+        next.allocate(capacity);
+        for (size_t i = 0; i < slotCount; ++i)
+        {
+            if (isFull(control[i]))
+            {
+                next.insertUnique(std::move(slots[i]));
+                slots[i].~value_type();
+            }
+        }
+        if (control)
+        {
+            std::memset(control, kEmpty, slotCount + kGroupWidth); // entries were destroyed above
+        }
+        used = 0;
+        tombstones = 0;
+        swap(next);
+    }
+
+private:
+    static constexpr size_t kGroupWidth = 16;
+    static constexpr int8_t kEmpty = -128; // 0b10000000
+    static constexpr int8_t kDeleted = -2; // 0b11111110; full slots hold 0..127
+
+    static bool isFull(int8_t c) { return c >= 0; }
+
+    // std::hash of integers is the identity; spread the bits so both tag and position vary
+    static size_t mix(size_t hash)
+    {
+        const uint64_t h = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h ^ (h >> 32));
+    }
+
+    size_t mask() const { return slotCount - 1; }
+
+    // The first kGroupWidth control bytes are mirrored after the end so a group never wraps
+    void setControl(size_t index, int8_t value)
+    {
+        control[index] = value;
+        if (index < kGroupWidth)
+        {
+            control[slotCount + index] = value;
+        }
+    }
+
+#if defined(__SSE2__)
+    uint32_t matchTag(size_t position, int8_t tag) const
+    {
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(control + position));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag))));
+    }
+    uint32_t matchEmpty(size_t position) const { return matchTag(position, kEmpty); }
+    // Empty and deleted both have the top bit set, so movemask of the group finds them
+    uint32_t matchFree(size_t position) const
+    {
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(control + position));
+        return static_cast<uint32_t>(_mm_movemask_epi8(group));
+    }
+#else
+    uint32_t matchTag(size_t position, int8_t tag) const
+    {
+        uint32_t match = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i)
+        {
+            match |= static_cast<uint32_t>(control[position + i] == tag) << i;
+        }
+        return match;
+    }
+    uint32_t matchEmpty(size_t position) const { return matchTag(position, kEmpty); }
+    uint32_t matchFree(size_t position) const
+    {
+        uint32_t match = 0;
+        for (size_t i = 0; i < kGroupWidth; ++i)
+        {
+            match |= static_cast<uint32_t>(control[position + i] < 0) << i;
+        }
+        return match;
+    }
+#endif
+
+    // Slot index holding key, or slotCount
+    size_t locate(const K &key) const
+    {
+        if (used == 0)
+        {
+            return slotCount;
+        }
+        const size_t hash = mix(Hash{}(key));
+        const int8_t tag = static_cast<int8_t>(hash & 0x7F);
+        for (size_t position = (hash >> 7) & mask();; position = (position + kGroupWidth) & mask())
+        {
+            for (uint32_t match = matchTag(position, tag); match; match &= match - 1)
+            {
+                const size_t index = (position + __builtin_ctz(match)) & mask();
+                if (Eq{}(slots[index].first, key))
+                {
+                    return index;
+                }
+            }
+            if (matchEmpty(position))
+            {
+                return slotCount;
+            }
+        }
+    }
+
+    // Insert a key known to be absent into a table with room and no tombstones
+    void insertUnique(value_type &&value)
+    {
+        const size_t hash = mix(Hash{}(value.first));
+        for (size_t position = (hash >> 7) & mask();; position = (position + kGroupWidth) & mask())
+        {
+            const uint32_t free = matchFree(position);
+            if (free)
+            {
+                const size_t index = (position + __builtin_ctz(free)) & mask();
+                new (&slots[index]) value_type(std::move(value));
+                setControl(index, static_cast<int8_t>(hash & 0x7F));
+                ++used;
+                return;
+            }
+        }
+    }
+
+    size_t nextFull(size_t index) const
+    {
+        while (index < slotCount && !isFull(control[index]))
+        {
+            ++index;
+        }
+        return index;
+    }
+
+    void allocate(size_t capacity)
+    {
+        slotCount = capacity;
+        control = new int8_t[capacity + kGroupWidth];
+        std::memset(control, kEmpty, capacity + kGroupWidth);
+        slots = std::allocator<value_type>().allocate(capacity);
+    }
+
+    void destroy()
+    {
+        clear();
+        if (slots)
+        {
+            std::allocator<value_type>().deallocate(slots, slotCount);
+        }
+        delete[] control;
+        slots = nullptr;
+        control = nullptr;
+        slotCount = 0;
+    }
+
+    int8_t *control = nullptr;
+    value_type *slots = nullptr;
+    size_t slotCount = 0;
+    size_t used = 0;
+    size_t tombstones = 0; // deleted slots, which still count towards the load
+};
+
+#endif // FLAT_HASH_MAP_H
@@ -0,0 +1,232 @@
+/*
+ * Author: Peter Arandorenko
+ * Date: January 26, 2024
+ */
+
+#ifndef FLAT_RECORD_H
+#define FLAT_RECORD_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/**
+ * Flat binary records: a schema fixes the type of every field, so each field lives at an offset
+ * known at compile time and reading one is a load from the buffer. There is no decode step and
+ * no allocation; strings come back as string_views into the buffer itself, which may be a
+ * received message or a mapped file.
+ *
+ * Layout of one record, in host byte order (little-endian on the platforms this is built for):
+ *   uint32 size                     bytes of the whole record, header included
+ *   fixed slots, in schema order    Int32: 4 bytes, Int64: 8 bytes,
+ *                                   String: uint32 offset from record start + uint32 length
+ *   string table                    string bytes back to back, no terminators
+ *
+ * Records are unaligned and may be concatenated; FlatStream walks such a buffer.
+ */
+enum class FlatType : uint8_t
+{
+    Int32,
+    Int64,
+    String
+};
+
+template <FlatType... Fields>
+struct FlatSchema
+{
+    static constexpr size_t kFieldCount = sizeof...(Fields);
+    static constexpr std::array<FlatType, kFieldCount> kTypes{Fields...};
+    static constexpr uint32_t kHeaderSize = sizeof(uint32_t);
+
+    static constexpr uint32_t slotSize(FlatType type) { return type == FlatType::Int32 ? 4 : 8; }
+
+    static constexpr std::array<uint32_t, kFieldCount> makeOffsets()
+    {
+        std::array<uint32_t, kFieldCount> offsets{};
+        uint32_t offset = kHeaderSize;
+        for (size_t i = 0; i < kFieldCount; ++i)
+        {
+            offsets[i] = offset;
+            offset += slotSize(kTypes[i]);
+        }
+        return offsets;
+    }
+
+    static constexpr std::array<uint32_t, kFieldCount> kOffsets = makeOffsets();
+    // Header plus slots; the string table starts here
+    static constexpr uint32_t kFixedSize = kFieldCount == 0 ? kHeaderSize : kOffsets[kFieldCount - 1] + slotSize(kTypes[kFieldCount - 1]);
+};
+
+namespace flat_detail
+{
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "flat records are stored in little-endian host order");
+
+    // memcpy rather than a cast: records are unaligned, and this compiles to a plain load
+    template <typename T>
+    T load(const char *at)
+    {
+        T value;
+        std::memcpy(&value, at, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void store(char *at, T value)
+    {
+        std::memcpy(at, &value, sizeof(T));
+    }
+
+    template <FlatType Type>
+    struct Value;
+    template <>
+    struct Value<FlatType::Int32>
+    {
+        using type = int32_t;
+    };
+    template <>
+    struct Value<FlatType::Int64>
+    {
+        using type = int64_t;
+    };
+    template <>
+    struct Value<FlatType::String>
+    {
+        using type = std::string_view;
+    };
+}
+
+/**
+ * Appends one record to out. Set fields in any order, then call finish(); unset integers read as
+ * 0 and unset strings as empty. Appending to a reused string allocates only while it grows.
+ */
+template <typename Schema>
+class FlatBuilder
+{
+public:
+    explicit FlatBuilder(std::string &out) : out(out), start(out.size())
+    {
+        out.resize(start + Schema::kFixedSize);
+    }
+
+    template <size_t I, typename V>
+    FlatBuilder &set(const V &value)
+    {
+        static_assert(I < Schema::kFieldCount, "field index out of range");
+        constexpr FlatType type = Schema::kTypes[I];
+        char *slot = out.data() + start + Schema::kOffsets[I];
+        if constexpr (type == FlatType::String)
+        {
+            const std::string_view text(value);
+            flat_detail::store<uint32_t>(slot, static_cast<uint32_t>(out.size() - start));
+            flat_detail::store<uint32_t>(slot + 4, static_cast<uint32_t>(text.size()));
+            out.append(text.data(), text.size()); // may reallocate, slot is not used after this
+        }
+        else
+        {
+            flat_detail::store(slot, static_cast<typename flat_detail::Value<type>::type>(value));
+        }
+        return *this;
+    }
+
+    // Write the record size; returns it. Records are limited to 4 GiB.
+    size_t finish()
+    {
+        const size_t size = out.size() - start;
+        flat_detail::store<uint32_t>(out.data() + start, static_cast<uint32_t>(size));
+        return size;
+    }
+
+private:
+    std::string &out;
+    const size_t start;
+};
+
+/**
+ * Read-only view of one record. The constructor checks the record size and that every string
+ * lies inside the record, O(fields) and independent of string lengths, so a view over untrusted
+ * bytes is either !ok() or safe to read. get<I>() must only be called on ok() views.
+ */
+template <typename Schema>
+class FlatView
+{
+public:
+    FlatView() = default;
+    FlatView(const char *data, size_t available)
+    {
+        if (available < Schema::kFixedSize)
+        {
+            return;
+        }
+        const uint32_t size = flat_detail::load<uint32_t>(data);
+        if (size < Schema::kFixedSize || size > available)
+        {
+            return;
+        }
+        for (size_t i = 0; i < Schema::kFieldCount; ++i)
+        {
+            if (Schema::kTypes[i] == FlatType::String)
+            {
+                const uint64_t offset = flat_detail::load<uint32_t>(data + Schema::kOffsets[i]);
+                const uint64_t length = flat_detail::load<uint32_t>(data + Schema::kOffsets[i] + 4);
+                if (length != 0 && (offset < Schema::kFixedSize || offset + length > size))
+                {
+                    return;
+                }
+            }
+        }
+        bytes = data;
+        length = size;
+    }
+
+    bool ok() const { return bytes != nullptr; }
+    size_t size() const { return length; }
+    const char *data() const { return bytes; }
+
+    template <size_t I>
+    typename flat_detail::Value<Schema::kTypes[I]>::type get() const
+    {
+        static_assert(I < Schema::kFieldCount, "field index out of range");
+        const char *slot = bytes + Schema::kOffsets[I];
+        if constexpr (Schema::kTypes[I] == FlatType::String)
+        {
+            return std::string_view(bytes + flat_detail::load<uint32_t>(slot), flat_detail::load<uint32_t>(slot + 4));
+        }
+        else
+        {
+            return flat_detail::load<typename flat_detail::Value<Schema::kTypes[I]>::type>(slot);
+        }
+    }
+
+private:
+    const char *bytes = nullptr;
+    size_t length = 0;
+};
+
+// Walks records laid out back to back, e.g. a file written by repeated FlatBuilder appends.
+template <typename Schema>
+class FlatStream
+{
+public:
+    FlatStream(const char *data, size_t size) : bytes(data), length(size) {}
+
+    // The next record, or a !ok() view at the end of the buffer or at a malformed record
+    FlatView<Schema> next()
+    {
+        FlatView<Schema> view(bytes + position, length - position);
+        position += view.size();
+        return view;
+    }
+
+    // True once every byte was consumed by well-formed records
+    bool done() const { return position == length; }
+
+private:
+    const char *bytes;
+    size_t length;
+    size_t position = 0;
+};
+
+#endif // FLAT_RECORD_H
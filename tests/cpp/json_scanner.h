@@ -0,0 +1,467 @@
+/*
+ * Author: Peter Arandorenko
+ * Date: January 26, 2024
+ */
+
+#ifndef JSON_SCANNER_H
+#define JSON_SCANNER_H
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <emmintrin.h>
+
+/**
+ * Stage one of a two-stage JSON parser in the style of simdjson. Input is classified 64 bytes at
+ * a time: SSE2 compares produce one bitmask per character class, escaped quotes are removed with
+ * carry arithmetic over the backslash mask, and a prefix XOR over the remaining quotes gives the
+ * bytes inside strings. What is left is the position of every token: structural characters and
+ * quotes outside strings, plus the first byte of each number or literal.
+ *
+ * Stage two (JsonCursor) walks those positions instead of the bytes, so it never looks inside a
+ * string to find where it ends.
+ */
+class JsonIndex
+{
+public:
+    /**
+     * Index text. Returns false if a string is left open, a string holds a raw control character
+     * or text is 4 GiB or larger; positions() is then incomplete. Strings are not checked for
+     * valid UTF-8 or escapes here, decodeJsonString does that for the strings that are used.
+     */
+    bool build(std::string_view text)
+    {
+        tokens.clear();
+        if (text.size() >= UINT32_MAX)
+        {
+            return false;
+        }
+        tokens.reserve(text.size() / 4);
+        uint64_t prevEscaped = 0, prevInString = 0, prevScalar = 0, controlInString = 0;
+        for (size_t base = 0; base < text.size(); base += 64)
+        {
+            const char *block = text.data() + base;
+            char tail[64];
+            if (text.size() - base < 64)
+            {
+                std::memset(tail, ' ', sizeof(tail)); // pad with whitespace, which adds no tokens
+                std::memcpy(tail, block, text.size() - base);
+                block = tail;
+            }
+            const Masks masks = classify(block);
+            const uint64_t quote = masks.quote & ~findEscaped(masks.backslash, prevEscaped);
+            const uint64_t inString = prefixXor(quote) ^ prevInString; // opening quote through last byte before closing
+            prevInString = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+            controlInString |= masks.control & inString;
+
+            const uint64_t structural = masks.structural & ~inString;
+            const uint64_t scalar = ~(masks.structural | masks.whitespace | masks.quote | inString);
+            const uint64_t scalarStarts = scalar & ~(scalar << 1 | prevScalar);
+            prevScalar = scalar >> 63;
+            emit(static_cast<uint32_t>(base), structural | quote | scalarStarts);
+        }
+        return prevInString == 0 && controlInString == 0;
+    }
+
+    const std::vector<uint32_t> &positions() const { return tokens; }
+
+private:
+    struct Masks
+    {
+        uint64_t quote = 0, backslash = 0, structural = 0, whitespace = 0, control = 0;
+    };
+
+    static Masks classify(const char *block)
+    {
+        Masks masks;
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * lane));
+            auto eq = [&](char c)
+            { return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)); };
+            auto bits = [&](__m128i match)
+            { return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(match))) << (16 * lane); };
+            // SSE2 has no byte shuffle for a nibble lookup table, so the classes are compare chains
+            const __m128i structural = _mm_or_si128(_mm_or_si128(_mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq('['), eq(']'))),
+                                                    _mm_or_si128(eq(':'), eq(',')));
+            const __m128i whitespace = _mm_or_si128(_mm_or_si128(eq(' '), eq('\n')), _mm_or_si128(eq('\r'), eq('\t')));
+            const __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+            masks.quote |= bits(eq('"'));
+            masks.backslash |= bits(eq('\\'));
+            masks.structural |= bits(structural);
+            masks.whitespace |= bits(whitespace);
+            masks.control |= bits(control);
+        }
+        return masks;
+    }
+
+    // Bits of the characters escaped by a backslash, i.e. preceded by an odd-length run of them.
+    // prevEscaped carries a run that crosses into the next block.
+    static uint64_t findEscaped(uint64_t backslash, uint64_t &prevEscaped)
+    {
+        backslash &= ~prevEscaped;
+        const uint64_t followsEscape = backslash << 1 | prevEscaped;
+        const uint64_t evenBits = 0x5555555555555555ULL;
+        const uint64_t oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+        uint64_t sequencesStartingOnEvenBits;
+        // Adding a run's start bit carries through the run and lands just past its end
+        prevEscaped = __builtin_add_overflow(oddSequenceStarts, backslash, &sequencesStartingOnEvenBits);
+        const uint64_t invertMask = sequencesStartingOnEvenBits << 1;
+        return (evenBits ^ invertMask) & followsEscape;
+    }
+
+    // Bit i becomes the XOR of bits 0..i: set from an opening quote up to its closing one
+    static uint64_t prefixXor(uint64_t bits)
+    {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+    void emit(uint32_t base, uint64_t bits)
+    {
+        while (bits)
+        {
+            tokens.push_back(base + static_cast<uint32_t>(__builtin_ctzll(bits)));
+            bits &= bits - 1;
+        }
+    }
+
+    std::vector<uint32_t> tokens;
+};
+
+/**
+ * Stage two: steps through the token positions of a JsonIndex. Every call checks the token kind
+ * it expects and returns false otherwise, so a caller parses one fixed shape without a DOM.
+ */
+class JsonCursor
+{
+public:
+    JsonCursor(std::string_view text, const std::vector<uint32_t> &positions)
+        : text(text), first(positions.data()), current(positions.data()), last(positions.data() + positions.size()) {}
+
+    bool atEnd() const { return current == last; }
+    // Byte offset of the current token; text.size() at the end
+    size_t position() const { return atEnd() ? text.size() : *current; }
+
+    bool consume(char structural)
+    {
+        if (!atEnd() && text[*current] == structural)
+        {
+            ++current;
+            return true;
+        }
+        return false;
+    }
+
+    // At an opening quote: the raw bytes up to the closing one, escapes not decoded
+    bool rawString(std::string_view &raw)
+    {
+        if (atEnd() || text[*current] != '"' || current + 1 == last)
+        {
+            return false;
+        }
+        const size_t begin = current[0] + 1;
+        raw = text.substr(begin, current[1] - begin); // nothing inside a string is a token
+        current += 2;
+        return true;
+    }
+
+    // At a number or literal: its bytes, which run up to the next token minus whitespace
+    bool scalar(std::string_view &value)
+    {
+        if (atEnd() || isStructuralOrQuote(text[*current]))
+        {
+            return false;
+        }
+        const size_t begin = *current++;
+        size_t end = position();
+        while (end > begin && isWhitespace(text[end - 1]))
+        {
+            --end;
+        }
+        value = text.substr(begin, end - begin);
+        return true;
+    }
+
+    // Move to the first token at or after offset
+    void seek(size_t offset) { current = std::lower_bound(first, last, offset); }
+
+private:
+    static bool isStructuralOrQuote(char c)
+    {
+        return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',' || c == '"';
+    }
+    static bool isWhitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    std::string_view text;
+    const uint32_t *first;
+    const uint32_t *current;
+    const uint32_t *last;
+};
+
+namespace json_detail
+{
+    inline bool hexValue(char c, uint32_t &value)
+    {
+        const uint32_t digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+        value = value << 4 | digit;
+        return digit < 16;
+    }
+
+    // Read the 4 hex digits of a \u escape starting at text[i]
+    inline bool hex4(std::string_view text, size_t i, uint32_t &value)
+    {
+        value = 0;
+        return i + 4 <= text.size() && hexValue(text[i], value) && hexValue(text[i + 1], value) &&
+               hexValue(text[i + 2], value) && hexValue(text[i + 3], value);
+    }
+
+    inline void appendUtf8(std::string &out, uint32_t code)
+    {
+        if (code < 0x80)
+        {
+            out += static_cast<char>(code);
+        }
+        else if (code < 0x800)
+        {
+            out += static_cast<char>(0xC0 | code >> 6);
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | code >> 12);
+            out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | code >> 18);
+            out += static_cast<char>(0x80 | (code >> 12 & 0x3F));
+            out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    // Length of the well-formed UTF-8 sequence at text[i], 0 if there is none
+    inline size_t utf8Sequence(std::string_view text, size_t i)
+    {
+        const auto byte = [&](size_t at)
+        { return at < text.size() ? static_cast<uint8_t>(text[at]) : 0; };
+        const uint8_t lead = byte(i);
+        const auto continuation = [&](size_t at, uint8_t low = 0x80, uint8_t high = 0xBF)
+        { return byte(at) >= low && byte(at) <= high; };
+        if (lead >= 0xC2 && lead <= 0xDF)
+            return continuation(i + 1) ? 2 : 0;
+        if (lead >= 0xE0 && lead <= 0xEF) // no overlongs, no surrogates
+            return continuation(i + 1, lead == 0xE0 ? 0xA0 : 0x80, lead == 0xED ? 0x9F : 0xBF) && continuation(i + 2) ? 3 : 0;
+        if (lead >= 0xF0 && lead <= 0xF4) // no overlongs, nothing past U+10FFFF
+            return continuation(i + 1, lead == 0xF0 ? 0x90 : 0x80, lead == 0xF4 ? 0x8F : 0xBF) && continuation(i + 2) && continuation(i + 3) ? 4 : 0;
+        return 0;
+    }
+
+    // True if raw has a backslash or a non-ASCII byte, checked 8 bytes at a time
+    inline bool needsDecoding(std::string_view raw)
+    {
+        constexpr uint64_t ones = 0x0101010101010101ULL, highs = 0x8080808080808080ULL;
+        size_t i = 0;
+        for (; i + 8 <= raw.size(); i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, raw.data() + i, sizeof(word));
+            const uint64_t backslashes = word ^ (ones * '\\');
+            if ((word | ((backslashes - ones) & ~backslashes)) & highs)
+            {
+                return true;
+            }
+        }
+        for (; i < raw.size(); ++i)
+        {
+            if (raw[i] == '\\' || static_cast<uint8_t>(raw[i]) >= 0x80)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+/**
+ * Decode the raw bytes of a JSON string (as returned by JsonCursor::rawString) into out. Plain
+ * ASCII without escapes, by far the common case, is a single copy. Returns false on an invalid
+ * escape, a lone surrogate or malformed UTF-8.
+ */
+inline bool decodeJsonString(std::string_view raw, std::string &out)
+{
+    if (!json_detail::needsDecoding(raw))
+    {
+        out.assign(raw.data(), raw.size());
+        return true;
+    }
+    out.clear();
+    for (size_t i = 0; i < raw.size();)
+    {
+        const char c = raw[i];
+        if (static_cast<uint8_t>(c) >= 0x80)
+        {
+            const size_t length = json_detail::utf8Sequence(raw, i);
+            if (length == 0)
+            {
+                return false;
+            }
+            out.append(raw.data() + i, length);
+            i += length;
+            continue;
+        }
+        if (c != '\\')
+        {
+            out += c;
+            ++i;
+            continue;
+        }
+        if (i + 1 >= raw.size())
+        {
+            return false;
+        }
+        const char escape = raw[i + 1];
+        i += 2;
+        switch (escape)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            out += escape;
+            break;
+        case 'b':
+            out += '\b';
+            break;
+        case 'f':
+            out += '\f';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 't':
+            out += '\t';
+            break;
+        case 'u':
+        {
+            uint32_t code;
+            if (!json_detail::hex4(raw, i, code))
+            {
+                return false;
+            }
+            i += 4;
+            if (code >= 0xDC00 && code <= 0xDFFF)
+            {
+                return false; // low surrogate without a high one
+            }
+            if (code >= 0xD800 && code <= 0xDBFF)
+            {
+                uint32_t low;
+                if (i + 2 > raw.size() || raw[i] != '\\' || raw[i + 1] != 'u' || !json_detail::hex4(raw, i + 2, low) ||
+                    low < 0xDC00 || low > 0xDFFF)
+                {
+                    return false;
+                }
+                i += 6;
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            json_detail::appendUtf8(out, code);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+// As above, but without a copy when none is needed: value views raw itself if it has no escapes
+// or non-ASCII bytes, otherwise the decoded text in scratch. Meant for keys, which are only compared.
+inline bool decodeJsonString(std::string_view raw, std::string &scratch, std::string_view &value)
+{
+    if (!json_detail::needsDecoding(raw))
+    {
+        value = raw;
+        return true;
+    }
+    if (!decodeJsonString(raw, scratch))
+    {
+        return false;
+    }
+    value = scratch;
+    return true;
+}
+
+// Parse a JSON integer that fits in int: -?(0|[1-9][0-9]*). Fractions and exponents are rejected.
+inline bool parseJsonInt(std::string_view text, int &value)
+{
+    const size_t digits = !text.empty() && text[0] == '-';
+    if (text.size() > digits + 1 && text[digits] == '0')
+    {
+        return false; // leading zero
+    }
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+/**
+ * Compile-time key dispatch: maps each of a fixed set of object keys to its index with one table
+ * lookup and one compare. The table is built by the constexpr constructor; declare the dispatch
+ * constexpr and static_assert(valid()) so that keys which collide fail the build.
+ */
+template <size_t N>
+class JsonKeyDispatch
+{
+public:
+    constexpr explicit JsonKeyDispatch(const std::array<std::string_view, N> &keys) : keys(keys)
+    {
+        for (int &slot : slots)
+        {
+            slot = -1;
+        }
+        for (size_t i = 0; i < N; ++i)
+        {
+            int &slot = slots[hash(keys[i])];
+            collision |= slot != -1;
+            slot = static_cast<int>(i);
+        }
+    }
+
+    constexpr bool valid() const { return !collision; }
+
+    // Index of key in the key list, or -1
+    constexpr int find(std::string_view key) const
+    {
+        const int index = slots[hash(key)];
+        return index >= 0 && keys[index] == key ? index : -1;
+    }
+
+private:
+    static constexpr size_t kSlots = 64;
+
+    static constexpr size_t hash(std::string_view key)
+    {
+        return key.empty() ? 0 : (key.size() * 7 + static_cast<uint8_t>(key.front()) * 3 + static_cast<uint8_t>(key.back())) % kSlots;
+    }
+
+    std::array<std::string_view, N> keys;
+    std::array<int, kSlots> slots{};
+    bool collision = false;
+};
+
+#endif // JSON_SCANNER_H
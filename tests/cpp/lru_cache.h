@@ -0,0 +1,1347 @@
+/*
+ * Author: Peter Arandorenko
+ * Date: January 26, 2024
+ */
+
+#ifndef LRU_CACHE_H
+#define LRU_CACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Key type used to index an LRUCache. std::string keys are indexed through a std::string_view that
+ * points into the cache's own copy of the key, which gives heterogeneous lookup: get("key") or get
+ * of a string_view never materialises a temporary std::string. Other keys are indexed by value.
+ */
+template <typename K>
+struct LRUKeyView
+{
+    using type = K;
+};
+
+template <>
+struct LRUKeyView<std::string>
+{
+    using type = std::string_view;
+};
+
+template <typename K>
+using LRUKeyViewT = typename LRUKeyView<K>::type;
+
+/**
+ * Least recently used cache. The list keeps items ordered from most to least recently used and
+ * the map stores the list iterator of every key to ensure O(1) access time complexity.
+ *
+ * Values are constructed in place and returned by pointer, so large payloads are never copied on
+ * put or get. The returned pointer stays valid until the entry is evicted or overwritten.
+ *
+ * Note: get() updates the recency list, so an instance must not be shared across threads
+ * without external locking. See ShardedLRUCache for the concurrent variant.
+ */
+template <typename K, typename V, typename Hash = std::hash<LRUKeyViewT<K>>>
+class LRUCache
+{
+public:
+    using key_view = LRUKeyViewT<K>;
+
+    LRUCache(size_t capacity) : capacity(capacity)
+    {
+    }
+
+    // Get value given key, marking it as most recently used. Returns nullptr if not found.
+    V *get(key_view key)
+    {
+        // Keep track of stored keys in a map to ensure O(1) access time complexity
+        auto it = map.find(key);
+        if (it == map.end())
+        {
+            return nullptr; // not found
+        }
+        // Update the cache since the key has been found. Need to update front to most recently used.
+        cache.splice(cache.begin(), cache, it->second);
+        return &it->second->second;
+    }
+
+    // Look up value given key without updating the recency list. Returns nullptr if not found.
+    const V *peek(key_view key) const
+    {
+        auto it = map.find(key);
+        return it == map.end() ? nullptr : &it->second->second;
+    }
+
+    // Mark key as most recently used without reading its value. Returns false if not found.
+    bool touch(key_view key)
+    {
+        auto it = map.find(key);
+        if (it == map.end())
+        {
+            return false;
+        }
+        cache.splice(cache.begin(), cache, it->second);
+        return true;
+    }
+
+    // Put key and value into least recently used cache. Rvalue arguments are moved, not copied.
+    template <typename KeyArg, typename ValueArg>
+    void put(KeyArg &&key, ValueArg &&value)
+    {
+        emplace(std::forward<KeyArg>(key), std::forward<ValueArg>(value));
+    }
+
+    /**
+     * Construct the value for key in place from args and mark it as most recently used.
+     * An existing value is replaced. Returns a reference to the stored value.
+     */
+    template <typename KeyArg, typename... Args>
+    V &emplace(KeyArg &&key, Args &&...args)
+    {
+        auto it = map.find(key_view(key));
+        if (it != map.end())
+        {
+            // Found it in the map. Update value and splice accordingly.
+            it->second->second = V(std::forward<Args>(args)...);
+            cache.splice(cache.begin(), cache, it->second);
+            return it->second->second;
+        }
+
+        if (cache.size() == capacity)
+        {
+            // Sync and update the map accordingly, since we will be adding to the map afterwards
+            // erase the k/v pair from map given oldest item in cache using its key
+            map.erase(key_view(cache.back().first));
+            cache.pop_back();
+        }
+
+        // Did not find it in the map. Must store in cache and map. The map key views the node key,
+        // so the node has to exist first.
+        cache.emplace_front(std::piecewise_construct,
+                            std::forward_as_tuple(std::forward<KeyArg>(key)),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+        map.emplace(key_view(cache.front().first), cache.begin());
+        return cache.front().second;
+    }
+
+    size_t size() const { return cache.size(); }
+
+private:
+    using Entry = std::pair<K, V>;
+
+    size_t capacity;
+    std::list<Entry> cache;
+    // Stores the beginning iterator of the cache, which holds the most recently used item that
+    // was pushed.
+    std::unordered_map<key_view, typename std::list<Entry>::iterator, Hash> map;
+};
+
+/**
+ * Concurrent LRU cache that splits the key space into independent shards. Every shard owns its
+ * own lock and LRU list, so threads that hit different shards never contend with each other.
+ *
+ * Reads come in two flavours:
+ * - Exact (default): get() takes the shard lock exclusively and promotes the key immediately.
+ * - Buffered: get() only takes the shard lock in shared mode, so concurrent readers of the same
+ *   shard proceed in parallel. The access is appended to a buffer owned by the calling thread and
+ *   the recency list is updated later, in one batch, when the buffer fills up. If the shard is
+ *   busy at that point the batch keeps growing, and beyond kMaxPendingReads the oldest hints are
+ *   dropped. This is the same trade-off CLOCK or TinyLFU style caches make: the eviction order
+ *   becomes approximate, in exchange for reads that never write to shared state.
+ */
+template <typename K, typename V, typename Hash = std::hash<LRUKeyViewT<K>>>
+class ShardedLRUCache
+{
+public:
+    using key_view = LRUKeyViewT<K>;
+
+    static constexpr size_t kReadBatchSize = 32;
+    static constexpr size_t kMaxPendingReads = 4 * kReadBatchSize;
+
+    /**
+     * @param capacity Total number of entries, split evenly across shards (rounded up).
+     * @param shardCount Number of shards, rounded up to a power of two.
+     * @param bufferedReads Enable the shared-lock read path with batched recency updates.
+     */
+    ShardedLRUCache(size_t capacity, size_t shardCount = 16, bool bufferedReads = false)
+        : id(nextId()), bufferedReads(bufferedReads)
+    {
+        size_t count = 1;
+        while (count < shardCount)
+        {
+            count <<= 1;
+        }
+        shardMask = count - 1;
+        const size_t perShard = (capacity + count - 1) / count;
+        shards.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            shards.push_back(std::make_unique<Shard>(perShard == 0 ? 1 : perShard));
+        }
+    }
+
+    /**
+     * Get a copy of the value given key, or std::nullopt on a miss.
+     * Unlike LRUCache::get() this cannot hand out a pointer: another thread may evict the entry
+     * as soon as the shard lock is released.
+     */
+    std::optional<V> get(key_view key)
+    {
+        const size_t index = shardFor(key);
+        Shard &shard = *shards[index];
+        if (!bufferedReads)
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            const V *found = shard.cache.get(key);
+            return found ? std::optional<V>(*found) : std::nullopt;
+        }
+
+        std::optional<V> value;
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            const V *found = shard.cache.peek(key);
+            if (!found)
+            {
+                return std::nullopt;
+            }
+            value.emplace(*found);
+        }
+        recordRead(index, key);
+        return value;
+    }
+
+    // Put key and value into the shard that owns key. Pending reads of that shard are applied first
+    // so that the eviction decision sees them.
+    template <typename KeyArg, typename ValueArg>
+    void put(KeyArg &&key, ValueArg &&value)
+    {
+        const size_t index = shardFor(key_view(key));
+        Shard &shard = *shards[index];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (bufferedReads)
+        {
+            replay(shard, readBuffer(index));
+        }
+        shard.cache.put(std::forward<KeyArg>(key), std::forward<ValueArg>(value));
+    }
+
+    // Total number of entries across all shards.
+    size_t size() const
+    {
+        size_t total = 0;
+        for (const auto &shard : shards)
+        {
+            std::shared_lock<std::shared_mutex> lock(shard->mutex);
+            total += shard->cache.size();
+        }
+        return total;
+    }
+
+    size_t shardCount() const { return shards.size(); }
+
+private:
+    struct Shard
+    {
+        explicit Shard(size_t capacity) : cache(capacity) {}
+        mutable std::shared_mutex mutex;
+        LRUCache<K, V, Hash> cache;
+    };
+
+    // Read buffers of the calling thread for one cache instance, one buffer per shard.
+    struct ThreadReadBuffers
+    {
+        uint64_t cacheId;
+        std::vector<std::vector<K>> perShard;
+    };
+
+    static uint64_t nextId()
+    {
+        static std::atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+
+    // std::hash of integers is the identity, so mix the bits before picking a shard.
+    size_t shardFor(key_view key) const
+    {
+        uint64_t h = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h >> 32) & shardMask;
+    }
+
+    // Buffers are keyed by cache id rather than address, so a new cache never inherits the hints
+    // of a destroyed one that happened to live at the same address.
+    std::vector<K> &readBuffer(size_t index)
+    {
+        thread_local std::vector<ThreadReadBuffers> buffers;
+        for (auto &entry : buffers)
+        {
+            if (entry.cacheId == id)
+            {
+                return entry.perShard[index];
+            }
+        }
+        if (buffers.size() >= 8)
+        {
+            // Bound the per-thread footprint when a thread touches many short-lived caches.
+            buffers.erase(buffers.begin());
+        }
+        buffers.push_back({id, std::vector<std::vector<K>>(shards.size())});
+        return buffers.back().perShard[index];
+    }
+
+    void recordRead(size_t index, key_view key)
+    {
+        std::vector<K> &pending = readBuffer(index);
+        pending.emplace_back(key);
+        if (pending.size() < kReadBatchSize)
+        {
+            return;
+        }
+        Shard &shard = *shards[index];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex, std::try_to_lock);
+        if (lock.owns_lock())
+        {
+            replay(shard, pending);
+        }
+        else if (pending.size() >= kMaxPendingReads)
+        {
+            // Shard is busy. Drop the oldest half, recency hints are best effort.
+            pending.erase(pending.begin(), pending.begin() + pending.size() / 2);
+        }
+    }
+
+    // Apply buffered accesses in the order they happened. Keys evicted meanwhile are skipped.
+    static void replay(Shard &shard, std::vector<K> &pending)
+    {
+        for (const K &key : pending)
+        {
+            shard.cache.touch(key);
+        }
+        pending.clear();
+    }
+
+    const uint64_t id;
+    const bool bufferedReads;
+    size_t shardMask = 0;
+    std::vector<std::unique_ptr<Shard>> shards;
+};
+
+/**
+ * Eviction policies for PolicyCache. A policy only tracks keys, the cache owns the values.
+ * Every policy implements the same interface:
+ *
+ *   explicit Policy(size_t capacity);
+ *   void recordHit(const K &key);                  // key is resident and was read or overwritten
+ *   std::optional<K> recordInsert(const K &key);   // key is not resident and is being added
+ *   void remove(const K &key);                     // key was dropped by the cache itself
+ *
+ * recordInsert() returns the resident key that must be evicted to stay within capacity. A policy
+ * with admission control may return the new key itself, meaning it was rejected.
+ */
+
+// Least recently used: the baseline, identical in behaviour to LRUCache.
+template <typename K, typename Hash = std::hash<K>>
+class LRUPolicy
+{
+public:
+    explicit LRUPolicy(size_t capacity) : capacity(capacity) {}
+
+    void recordHit(const K &key)
+    {
+        auto it = map.find(key);
+        if (it != map.end())
+        {
+            order.splice(order.begin(), order, it->second);
+        }
+    }
+
+    std::optional<K> recordInsert(const K &key)
+    {
+        order.push_front(key);
+        map[key] = order.begin();
+        if (order.size() <= capacity)
+        {
+            return std::nullopt;
+        }
+        K victim = std::move(order.back());
+        order.pop_back();
+        map.erase(victim);
+        return victim;
+    }
+
+    void remove(const K &key)
+    {
+        auto it = map.find(key);
+        if (it != map.end())
+        {
+            order.erase(it->second);
+            map.erase(it);
+        }
+    }
+
+private:
+    size_t capacity;
+    std::list<K> order;
+    std::unordered_map<K, typename std::list<K>::iterator, Hash> map;
+};
+
+/**
+ * CLOCK: an LRU approximation where a hit only sets a reference bit. On eviction the hand sweeps
+ * the ring, giving every referenced entry a second chance, and evicts the first unreferenced one.
+ */
+template <typename K, typename Hash = std::hash<K>>
+class ClockPolicy
+{
+public:
+    explicit ClockPolicy(size_t capacity) : slots(capacity == 0 ? 1 : capacity) {}
+
+    void recordHit(const K &key)
+    {
+        auto it = map.find(key);
+        if (it != map.end())
+        {
+            slots[it->second].referenced = true;
+        }
+    }
+
+    std::optional<K> recordInsert(const K &key)
+    {
+        if (!freeSlots.empty() || used < slots.size())
+        {
+            size_t index;
+            if (!freeSlots.empty())
+            {
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            }
+            else
+            {
+                index = used++;
+            }
+            slots[index] = Slot{key, false, true};
+            map[key] = index;
+            return std::nullopt;
+        }
+
+        // Ring is full: sweep until an unreferenced slot is found, clearing bits on the way.
+        while (slots[hand].referenced)
+        {
+            slots[hand].referenced = false;
+            hand = (hand + 1) % slots.size();
+        }
+        K victim = std::move(slots[hand].key);
+        map.erase(victim);
+        slots[hand] = Slot{key, false, true};
+        map[key] = hand;
+        hand = (hand + 1) % slots.size();
+        return victim;
+    }
+
+    void remove(const K &key)
+    {
+        auto it = map.find(key);
+        if (it != map.end())
+        {
+            slots[it->second].occupied = false;
+            slots[it->second].referenced = false;
+            freeSlots.push_back(it->second);
+            map.erase(it);
+        }
+    }
+
+private:
+    struct Slot
+    {
+        K key{};
+        bool referenced = false;
+        bool occupied = false;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<size_t> freeSlots;
+    size_t used = 0;
+    size_t hand = 0;
+    std::unordered_map<K, size_t, Hash> map;
+};
+
+/**
+ * 2Q (Johnson & Shasha, full version). New keys enter a small FIFO (A1in, 25% of capacity).
+ * Keys evicted from it are remembered in a ghost FIFO (A1out). Only a key that comes back while
+ * still remembered is promoted to the main LRU (Am), so a one-off scan flows through A1in without
+ * touching the hot set.
+ */
+template <typename K, typename Hash = std::hash<K>>
+class TwoQueuePolicy
+{
+public:
+    explicit TwoQueuePolicy(size_t capacity)
+        : capacity(capacity == 0 ? 1 : capacity),
+          inCapacity(std::max<size_t>(1, this->capacity / 4)),
+          outCapacity(std::max<size_t>(1, this->capacity / 2))
+    {
+    }
+
+    void recordHit(const K &key)
+    {
+        auto it = resident.find(key);
+        if (it != resident.end() && it->second.inMain)
+        {
+            main.splice(main.begin(), main, it->second.position);
+        }
+        // Hits in A1in are deliberately ignored: correlated references should not promote.
+    }
+
+    std::optional<K> recordInsert(const K &key)
+    {
+        auto ghost = ghostMap.find(key);
+        if (ghost != ghostMap.end())
+        {
+            ghosts.erase(ghost->second);
+            ghostMap.erase(ghost);
+            main.push_front(key);
+            resident[key] = Location{true, main.begin()};
+        }
+        else
+        {
+            in.push_front(key);
+            resident[key] = Location{false, in.begin()};
+        }
+
+        if (resident.size() <= capacity)
+        {
+            return std::nullopt;
+        }
+        if (in.size() > inCapacity || main.empty())
+        {
+            K victim = in.back();
+            in.pop_back();
+            resident.erase(victim);
+            rememberGhost(victim);
+            return victim;
+        }
+        K victim = std::move(main.back());
+        main.pop_back();
+        resident.erase(victim);
+        return victim;
+    }
+
+    void remove(const K &key)
+    {
+        auto it = resident.find(key);
+        if (it != resident.end())
+        {
+            (it->second.inMain ? main : in).erase(it->second.position);
+            resident.erase(it);
+        }
+    }
+
+private:
+    struct Location
+    {
+        bool inMain;
+        typename std::list<K>::iterator position;
+    };
+
+    void rememberGhost(const K &key)
+    {
+        ghosts.push_front(key);
+        ghostMap[key] = ghosts.begin();
+        if (ghosts.size() > outCapacity)
+        {
+            ghostMap.erase(ghosts.back());
+            ghosts.pop_back();
+        }
+    }
+
+    size_t capacity;
+    size_t inCapacity;
+    size_t outCapacity;
+    std::list<K> in;
+    std::list<K> main;
+    std::list<K> ghosts;
+    std::unordered_map<K, Location, Hash> resident;
+    std::unordered_map<K, typename std::list<K>::iterator, Hash> ghostMap;
+};
+
+/**
+ * ARC (Megiddo & Modha). Resident keys live in T1 (seen once recently) or T2 (seen at least
+ * twice). B1 and B2 remember keys recently evicted from each. A hit in a ghost list shifts the
+ * adaptive target p, the share of the cache given to T1, towards the list that would have hit.
+ */
+template <typename K, typename Hash = std::hash<K>>
+class ARCPolicy
+{
+public:
+    explicit ARCPolicy(size_t capacity) : capacity(capacity == 0 ? 1 : capacity) {}
+
+    void recordHit(const K &key)
+    {
+        auto it = where.find(key);
+        if (it != where.end() && (it->second.list == T1 || it->second.list == T2))
+        {
+            moveTo(it, T2);
+        }
+    }
+
+    std::optional<K> recordInsert(const K &key)
+    {
+        std::optional<K> victim;
+        auto it = where.find(key);
+        if (it != where.end() && it->second.list == B1)
+        {
+            // Case II: recency ghost hit, grow T1's target.
+            const size_t delta = std::max<size_t>(1, lists[B2].size() / lists[B1].size());
+            target = std::min(capacity, target + delta);
+            victim = replace(false);
+            moveTo(where.find(key), T2);
+            return victim;
+        }
+        if (it != where.end() && it->second.list == B2)
+        {
+            // Case III: frequency ghost hit, shrink T1's target.
+            const size_t delta = std::max<size_t>(1, lists[B1].size() / lists[B2].size());
+            target = target > delta ? target - delta : 0;
+            victim = replace(true);
+            moveTo(where.find(key), T2);
+            return victim;
+        }
+
+        // Case IV: completely new key.
+        const size_t l1 = lists[T1].size() + lists[B1].size();
+        const size_t total = l1 + lists[T2].size() + lists[B2].size();
+        if (l1 >= capacity)
+        {
+            if (lists[T1].size() < capacity)
+            {
+                dropLru(B1);
+                victim = replace(false);
+            }
+            else
+            {
+                victim = lists[T1].back();
+                dropLru(T1);
+            }
+        }
+        else if (total >= capacity)
+        {
+            if (total >= 2 * capacity)
+            {
+                dropLru(B2);
+            }
+            victim = replace(false);
+        }
+        lists[T1].push_front(key);
+        where[key] = Location{T1, lists[T1].begin()};
+        return victim;
+    }
+
+    void remove(const K &key)
+    {
+        auto it = where.find(key);
+        if (it != where.end() && (it->second.list == T1 || it->second.list == T2))
+        {
+            lists[it->second.list].erase(it->second.position);
+            where.erase(it);
+        }
+    }
+
+private:
+    enum ListId
+    {
+        T1,
+        T2,
+        B1,
+        B2
+    };
+
+    struct Location
+    {
+        ListId list;
+        typename std::list<K>::iterator position;
+    };
+
+    using Iterator = typename std::unordered_map<K, Location, Hash>::iterator;
+
+    void moveTo(Iterator it, ListId to)
+    {
+        std::list<K> &from = lists[it->second.list];
+        lists[to].splice(lists[to].begin(), from, it->second.position);
+        it->second = Location{to, lists[to].begin()};
+    }
+
+    void dropLru(ListId id)
+    {
+        if (!lists[id].empty())
+        {
+            where.erase(lists[id].back());
+            lists[id].pop_back();
+        }
+    }
+
+    // Evict the LRU page of T1 or T2 into its ghost list, only when the resident set is full.
+    std::optional<K> replace(bool hitInB2)
+    {
+        if (lists[T1].size() + lists[T2].size() < capacity)
+        {
+            return std::nullopt;
+        }
+        const size_t t1 = lists[T1].size();
+        const bool fromT1 = t1 > 0 && (t1 > target || (hitInB2 && t1 == target));
+        const ListId source = fromT1 || lists[T2].empty() ? T1 : T2;
+        K victim = lists[source].back();
+        moveTo(where.find(victim), source == T1 ? B1 : B2);
+        return victim;
+    }
+
+    size_t capacity;
+    size_t target = 0;
+    std::list<K> lists[4];
+    std::unordered_map<K, Location, Hash> where;
+};
+
+/**
+ * 4-bit Count-Min sketch used by W-TinyLFU to estimate how often a key was seen. Counters are
+ * halved every sampleSize increments so that old popularity fades.
+ */
+template <typename K, typename Hash = std::hash<K>>
+class FrequencySketch
+{
+public:
+    explicit FrequencySketch(size_t capacity) : sampleSize(10 * std::max<size_t>(capacity, 16))
+    {
+        size_t width = 16;
+        while (width < capacity)
+        {
+            width <<= 1;
+        }
+        mask = width - 1;
+        for (auto &row : rows)
+        {
+            row.assign(width, 0);
+        }
+    }
+
+    void increment(const K &key)
+    {
+        const uint64_t h = Hash{}(key);
+        for (size_t i = 0; i < kDepth; ++i)
+        {
+            uint8_t &counter = rows[i][index(h, i)];
+            if (counter < 15)
+            {
+                ++counter;
+            }
+        }
+        if (++additions >= sampleSize)
+        {
+            age();
+        }
+    }
+
+    uint8_t estimate(const K &key) const
+    {
+        const uint64_t h = Hash{}(key);
+        uint8_t result = 15;
+        for (size_t i = 0; i < kDepth; ++i)
+        {
+            result = std::min(result, rows[i][index(h, i)]);
+        }
+        return result;
+    }
+
+private:
+    static constexpr size_t kDepth = 4;
+
+    size_t index(uint64_t h, size_t row) const
+    {
+        static constexpr uint64_t seeds[kDepth] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full,
+                                                   0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull};
+        return static_cast<size_t>(((h + row) * seeds[row]) >> 32) & mask;
+    }
+
+    void age()
+    {
+        for (auto &row : rows)
+        {
+            for (auto &counter : row)
+            {
+                counter >>= 1;
+            }
+        }
+        additions /= 2;
+    }
+
+    std::vector<uint8_t> rows[kDepth];
+    size_t mask = 0;
+    size_t sampleSize;
+    size_t additions = 0;
+};
+
+/**
+ * W-TinyLFU (Einziger, Friedman & Manes). New keys enter a small LRU window (1% of capacity).
+ * When the window overflows, its LRU key competes with the LRU key of the main segmented LRU
+ * and only the one with the higher estimated frequency stays. Scans therefore pass through the
+ * window without displacing frequently used entries. The main region is split into probation
+ * (20%) and protected (80%) segments.
+ */
+template <typename K, typename Hash = std::hash<K>>
+class WTinyLFUPolicy
+{
+public:
+    explicit WTinyLFUPolicy(size_t capacity)
+        : windowCapacity(std::max<size_t>(1, capacity / 100)),
+          mainCapacity(capacity > windowCapacity ? capacity - windowCapacity : 0),
+          protectedCapacity(mainCapacity * 4 / 5),
+          sketch(capacity)
+    {
+    }
+
+    void recordHit(const K &key)
+    {
+        sketch.increment(key);
+        auto it = where.find(key);
+        if (it == where.end())
+        {
+            return;
+        }
+        if (it->second.segment == Probation)
+        {
+            // Promote, and demote the protected LRU back to probation if protected is full.
+            moveTo(it, Protected);
+            if (lists[Protected].size() > protectedCapacity)
+            {
+                moveTo(where.find(lists[Protected].back()), Probation);
+            }
+            return;
+        }
+        moveTo(it, it->second.segment);
+    }
+
+    std::optional<K> recordInsert(const K &key)
+    {
+        sketch.increment(key);
+        lists[Window].push_front(key);
+        where[key] = Location{Window, lists[Window].begin()};
+        if (lists[Window].size() <= windowCapacity)
+        {
+            return std::nullopt;
+        }
+
+        K candidate = lists[Window].back();
+        if (lists[Probation].size() + lists[Protected].size() < mainCapacity)
+        {
+            moveTo(where.find(candidate), Probation);
+            return std::nullopt;
+        }
+
+        // Main region is full: admit the candidate only if it is more popular than the victim.
+        const Segment victimSegment = lists[Probation].empty() ? Protected : Probation;
+        if (mainCapacity == 0 || sketch.estimate(candidate) <= sketch.estimate(lists[victimSegment].back()))
+        {
+            where.erase(candidate);
+            lists[Window].pop_back();
+            return candidate;
+        }
+        K victim = lists[victimSegment].back();
+        where.erase(victim);
+        lists[victimSegment].pop_back();
+        moveTo(where.find(candidate), Probation);
+        return victim;
+    }
+
+    void remove(const K &key)
+    {
+        auto it = where.find(key);
+        if (it != where.end())
+        {
+            lists[it->second.segment].erase(it->second.position);
+            where.erase(it);
+        }
+    }
+
+private:
+    enum Segment
+    {
+        Window,
+        Probation,
+        Protected
+    };
+
+    struct Location
+    {
+        Segment segment;
+        typename std::list<K>::iterator position;
+    };
+
+    using Iterator = typename std::unordered_map<K, Location, Hash>::iterator;
+
+    void moveTo(Iterator it, Segment to)
+    {
+        std::list<K> &from = lists[it->second.segment];
+        lists[to].splice(lists[to].begin(), from, it->second.position);
+        it->second = Location{to, lists[to].begin()};
+    }
+
+    size_t windowCapacity;
+    size_t mainCapacity;
+    size_t protectedCapacity;
+    FrequencySketch<K, Hash> sketch;
+    std::list<K> lists[3];
+    std::unordered_map<K, Location, Hash> where;
+};
+
+/**
+ * Cache with a pluggable eviction policy. Values are stored in a hash map and the policy decides
+ * which key leaves when the cache is full, e.g. PolicyCache<int, string, WTinyLFUPolicy>.
+ * Hit and miss counters make it easy to compare policies on the same trace.
+ */
+template <typename K, typename V, template <typename, typename> class Policy = LRUPolicy,
+          typename Hash = std::hash<K>>
+class PolicyCache
+{
+public:
+    explicit PolicyCache(size_t capacity) : policy(capacity) {}
+
+    // Get value given key. Returns nullptr if not found.
+    V *get(const K &key)
+    {
+        auto it = values.find(key);
+        if (it == values.end())
+        {
+            ++missCount;
+            return nullptr;
+        }
+        ++hitCount;
+        policy.recordHit(key);
+        return &it->second;
+    }
+
+    template <typename KeyArg, typename ValueArg>
+    V *put(KeyArg &&key, ValueArg &&value)
+    {
+        return emplace(std::forward<KeyArg>(key), std::forward<ValueArg>(value));
+    }
+
+    /**
+     * Construct the value for key in place. Returns the stored value, or nullptr if the policy's
+     * admission filter rejected the new key.
+     */
+    template <typename KeyArg, typename... Args>
+    V *emplace(KeyArg &&key, Args &&...args)
+    {
+        auto it = values.find(key);
+        if (it != values.end())
+        {
+            it->second = V(std::forward<Args>(args)...);
+            policy.recordHit(it->first);
+            return &it->second;
+        }
+
+        K owned(std::forward<KeyArg>(key));
+        std::optional<K> victim = policy.recordInsert(owned);
+        if (victim && *victim == owned)
+        {
+            return nullptr;
+        }
+        if (victim)
+        {
+            values.erase(*victim);
+            ++evictionCount;
+        }
+        auto inserted = values.emplace(std::piecewise_construct,
+                                       std::forward_as_tuple(std::move(owned)),
+                                       std::forward_as_tuple(std::forward<Args>(args)...));
+        return &inserted.first->second;
+    }
+
+    // Drop key from the cache. Returns false if it was not resident.
+    bool erase(const K &key)
+    {
+        if (values.erase(key) == 0)
+        {
+            return false;
+        }
+        policy.remove(key);
+        return true;
+    }
+
+    size_t size() const { return values.size(); }
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+    size_t evictions() const { return evictionCount; }
+    double hitRatio() const
+    {
+        const size_t total = hitCount + missCount;
+        return total == 0 ? 0.0 : static_cast<double>(hitCount) / total;
+    }
+
+private:
+    Policy<K, Hash> policy;
+    std::unordered_map<K, V, Hash> values;
+    size_t hitCount = 0;
+    size_t missCount = 0;
+    size_t evictionCount = 0;
+};
+
+/**
+ * Hierarchical timing wheel (Varghese & Lauck). Level 0 has one slot per tick, and every level
+ * above covers 64 times the range of the one below. A timer is placed on the lowest level whose
+ * range reaches its expiry. When the level below wraps around, the timers of the next slot up
+ * are cascaded down. Scheduling and cancelling are O(1), and advancing costs O(expired timers)
+ * plus one step per tick. Runs of empty ticks are skipped.
+ *
+ * Callers own a Handle per timer. The wheel keeps it up to date when timers cascade, so cancel()
+ * never has to search.
+ */
+template <typename Payload>
+class HierarchicalTimingWheel
+{
+    struct Timer;
+
+public:
+    static constexpr unsigned kLevels = 4;
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr uint64_t kSlots = 1ull << kSlotBits;
+
+    struct Handle
+    {
+        bool active = false;
+        unsigned level = 0;
+        uint64_t slot = 0;
+        typename std::list<Timer>::iterator position;
+    };
+
+    explicit HierarchicalTimingWheel(uint64_t startTick = 0) : currentTick(startTick) {}
+
+    // Schedule payload to fire at expiryTick. A handle that is already active is rescheduled.
+    void schedule(Handle &handle, uint64_t expiryTick, Payload payload)
+    {
+        cancel(handle);
+        place(Timer{std::max(expiryTick, currentTick + 1), std::move(payload), &handle});
+    }
+
+    void cancel(Handle &handle)
+    {
+        if (!handle.active)
+        {
+            return;
+        }
+        slots[handle.level][handle.slot].erase(handle.position);
+        --counts[handle.level];
+        handle.active = false;
+    }
+
+    // Advance to tick and call onExpire(payload) for every timer that expired on the way.
+    template <typename OnExpire>
+    void advance(uint64_t tick, OnExpire &&onExpire)
+    {
+        while (currentTick < tick)
+        {
+            if (size() == 0)
+            {
+                currentTick = tick;
+                return;
+            }
+            // Jump over ticks that cannot fire anything: if the lower levels are empty, nothing
+            // happens until the next slot boundary of the first non-empty level.
+            for (unsigned level = 0; level + 1 < kLevels && counts[level] == 0; ++level)
+            {
+                const uint64_t span = 1ull << (kSlotBits * (level + 1));
+                const uint64_t boundary = (currentTick | (span - 1));
+                currentTick = std::max(currentTick, std::min(boundary, tick - 1));
+            }
+            ++currentTick;
+            cascade(1);
+            std::list<Timer> &due = slots[0][currentTick & (kSlots - 1)];
+            while (!due.empty())
+            {
+                Timer timer = std::move(due.front());
+                due.pop_front();
+                --counts[0];
+                timer.handle->active = false;
+                onExpire(timer.payload);
+            }
+        }
+    }
+
+    uint64_t tick() const { return currentTick; }
+
+    size_t size() const
+    {
+        size_t total = 0;
+        for (size_t count : counts)
+        {
+            total += count;
+        }
+        return total;
+    }
+
+private:
+    struct Timer
+    {
+        uint64_t expiry;
+        Payload payload;
+        Handle *handle;
+    };
+
+    // When level - 1 wraps to slot 0, move the timers of the current slot of level down.
+    void cascade(unsigned level)
+    {
+        if (level >= kLevels || (currentTick & ((1ull << (kSlotBits * level)) - 1)) != 0)
+        {
+            return;
+        }
+        cascade(level + 1);
+        std::list<Timer> &source = slots[level][(currentTick >> (kSlotBits * level)) & (kSlots - 1)];
+        while (!source.empty())
+        {
+            --counts[level];
+            Timer &timer = source.front();
+            const auto target = locate(timer.expiry);
+            slots[target.first][target.second].splice(slots[target.first][target.second].end(), source, source.begin());
+            ++counts[target.first];
+            timer.handle->level = target.first;
+            timer.handle->slot = target.second;
+        }
+    }
+
+    std::pair<unsigned, uint64_t> locate(uint64_t expiry) const
+    {
+        const uint64_t delta = expiry > currentTick ? expiry - currentTick : 0;
+        for (unsigned level = 0; level < kLevels; ++level)
+        {
+            if (delta < (1ull << (kSlotBits * (level + 1))))
+            {
+                return {level, (expiry >> (kSlotBits * level)) & (kSlots - 1)};
+            }
+        }
+        // Beyond the wheel's range: park in the slot furthest away on the top level. The timer is
+        // re-placed when that slot cascades.
+        const unsigned top = kLevels - 1;
+        return {top, ((currentTick >> (kSlotBits * top)) - 1) & (kSlots - 1)};
+    }
+
+    void place(Timer timer)
+    {
+        const auto target = locate(timer.expiry);
+        std::list<Timer> &slot = slots[target.first][target.second];
+        Handle &handle = *timer.handle;
+        slot.push_back(std::move(timer));
+        ++counts[target.first];
+        handle.active = true;
+        handle.level = target.first;
+        handle.slot = target.second;
+        handle.position = std::prev(slot.end());
+    }
+
+    uint64_t currentTick;
+    std::list<Timer> slots[kLevels][kSlots];
+    size_t counts[kLevels] = {};
+};
+
+/**
+ * Default charge of a cache entry: the bytes of key and value, including the heap payload of
+ * strings and vectors. Supply your own functor for other types that own heap memory.
+ */
+struct PayloadSize
+{
+    template <typename T>
+    size_t operator()(const T &) const { return sizeof(T); }
+
+    size_t operator()(const std::string &value) const { return sizeof(std::string) + value.capacity(); }
+
+    template <typename T>
+    size_t operator()(const std::vector<T> &value) const
+    {
+        return sizeof(std::vector<T>) + value.capacity() * sizeof(T);
+    }
+
+    template <typename K, typename V>
+    size_t operator()(const K &key, const V &value) const { return (*this)(key) + (*this)(value); }
+};
+
+// Memory footprint of an ExpiringLRUCache.
+struct CacheStats
+{
+    size_t entries = 0;
+    size_t capacityBytes = 0;
+    size_t chargedBytes = 0;  // sum of SizeFn over all entries
+    size_t overheadBytes = 0; // estimated list nodes, hash nodes and buckets
+    size_t pendingTimers = 0;
+    size_t evictions = 0;
+    size_t expirations = 0;
+    size_t rejections = 0; // entries larger than the whole cache
+
+    size_t footprintBytes() const { return chargedBytes + overheadBytes; }
+};
+
+/**
+ * LRU cache bounded by bytes rather than entries, with an optional time to live per entry.
+ * Every entry is charged SizeFn(key, value) bytes, and the least recently used entries are evicted
+ * until the new one fits. Expired entries are removed by a hierarchical timing wheel, which is
+ * advanced on every call or explicitly through expire(). Nothing ever scans the cache.
+ *
+ * Clock is any type with a static now() returning a std::chrono time_point. Tests can inject a
+ * manual clock.
+ */
+template <typename K, typename V, typename SizeFn = PayloadSize, typename Clock = std::chrono::steady_clock,
+          typename Hash = std::hash<LRUKeyViewT<K>>>
+class ExpiringLRUCache
+{
+public:
+    using key_view = LRUKeyViewT<K>;
+    using duration = std::chrono::milliseconds;
+
+    /**
+     * @param capacityBytes Upper bound on the charged bytes of all entries.
+     * @param tick Resolution of expiry. Entries expire at most one tick late.
+     */
+    explicit ExpiringLRUCache(size_t capacityBytes, duration tick = duration(1), SizeFn sizeOf = SizeFn())
+        : capacityBytes(capacityBytes), tickLength(tick.count() > 0 ? tick : duration(1)),
+          epoch(Clock::now()), sizeOf(std::move(sizeOf))
+    {
+    }
+
+    // Timers hold iterators into this cache's own list, so a copy would share them
+    ExpiringLRUCache(const ExpiringLRUCache &) = delete;
+    ExpiringLRUCache &operator=(const ExpiringLRUCache &) = delete;
+
+    // Get value given key. Returns nullptr if not found or expired.
+    V *get(key_view key)
+    {
+        expire();
+        auto it = map.find(key);
+        if (it == map.end())
+        {
+            return nullptr;
+        }
+        cache.splice(cache.begin(), cache, it->second);
+        return &it->second->value;
+    }
+
+    /**
+     * Put key and value. A zero ttl means the entry never expires. Returns false, and drops any
+     * previous value of key, if the entry alone exceeds the capacity.
+     */
+    template <typename KeyArg, typename ValueArg>
+    bool put(KeyArg &&key, ValueArg &&value, duration ttl = duration::zero())
+    {
+        expire();
+        auto it = map.find(key_view(key));
+        if (it != map.end())
+        {
+            erase(it->second);
+        }
+
+        Entry entry{K(std::forward<KeyArg>(key)), V(std::forward<ValueArg>(value))};
+        entry.charge = sizeOf(entry.key, entry.value);
+        if (entry.charge > capacityBytes)
+        {
+            ++rejections;
+            return false;
+        }
+        while (chargedBytes + entry.charge > capacityBytes)
+        {
+            erase(std::prev(cache.end()));
+            ++evictions;
+        }
+
+        chargedBytes += entry.charge;
+        cache.push_front(std::move(entry));
+        map.emplace(key_view(cache.front().key), cache.begin());
+        if (ttl > duration::zero())
+        {
+            const uint64_t ticks = (ttl.count() + tickLength.count() - 1) / tickLength.count();
+            wheel.schedule(cache.front().timer, wheel.tick() + ticks, cache.begin());
+        }
+        return true;
+    }
+
+    bool erase(key_view key)
+    {
+        auto it = map.find(key);
+        if (it == map.end())
+        {
+            return false;
+        }
+        erase(it->second);
+        return true;
+    }
+
+    // Remove every entry whose time to live has elapsed.
+    void expire()
+    {
+        const auto elapsed = std::chrono::duration_cast<duration>(Clock::now() - epoch);
+        const uint64_t now = elapsed.count() <= 0 ? 0 : static_cast<uint64_t>(elapsed.count() / tickLength.count());
+        wheel.advance(now, [this](typename std::list<Entry>::iterator entry)
+                      {
+            erase(entry);
+            ++expirations; });
+    }
+
+    size_t size() const { return cache.size(); }
+    size_t bytes() const { return chargedBytes; }
+
+    CacheStats stats() const
+    {
+        CacheStats result;
+        result.entries = cache.size();
+        result.capacityBytes = capacityBytes;
+        result.chargedBytes = chargedBytes;
+        // A list node holds the entry plus two links. A hash node holds the key view, iterator,
+        // cached hash and a link. Buckets are one pointer each.
+        const size_t listNode = sizeof(Entry) + 2 * sizeof(void *);
+        const size_t hashNode = sizeof(std::pair<key_view, void *>) + 2 * sizeof(void *);
+        result.overheadBytes = cache.size() * (listNode + hashNode) + map.bucket_count() * sizeof(void *);
+        result.pendingTimers = wheel.size();
+        result.evictions = evictions;
+        result.expirations = expirations;
+        result.rejections = rejections;
+        return result;
+    }
+
+private:
+    struct Entry;
+    using Iterator = typename std::list<Entry>::iterator;
+
+    struct Entry
+    {
+        K key;
+        V value;
+        size_t charge = 0;
+        typename HierarchicalTimingWheel<Iterator>::Handle timer{};
+    };
+
+    void erase(Iterator entry)
+    {
+        wheel.cancel(entry->timer);
+        chargedBytes -= entry->charge;
+        map.erase(key_view(entry->key));
+        cache.erase(entry);
+    }
+
+    size_t capacityBytes;
+    size_t chargedBytes = 0;
+    size_t evictions = 0;
+    size_t expirations = 0;
+    size_t rejections = 0;
+    duration tickLength;
+    typename Clock::time_point epoch;
+    SizeFn sizeOf;
+    std::list<Entry> cache;
+    std::unordered_map<key_view, Iterator, Hash> map;
+    HierarchicalTimingWheel<Iterator> wheel;
+};
+
+#endif // LRU_CACHE_H
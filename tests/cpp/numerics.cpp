@@ -1,129 +1,554 @@
-#include <gtest/gtest.h>
-#include <vector>
-#include <string>
-#include <limits.h>
-#include <cmath>
-
-using namespace std;
-
-namespace Numerics
-{
-    class Numerics
-    {
-    public:
-        /**
-         * Reverses digits given an input integer using recursion.
-         * Returns the reversed digits of given integer.
-         * TODO: Support integers ending in zeros.
-         * TODO: Support reversing integers ending in zeros.
-         * @param in Input integer
-         * @param out Partially reversed integer used in recusion
-         * @return T Reversed integer result.
-         */
-        template <typename T>
-        static T reverseDigitsRecursive(const T &in, const T &out = 0)
-        {
-            const T input = std::move(in);
-            if (input == 0)
-            {
-                return out;
-            }
-            const T &rem = input % 10;
-            return reverseDigitsRecursive((input - rem) / 10, out * 10 + rem);
-        }
-
-        /**
-         * Reverses digits given an input integer. Non-recursive.
-         * Note: Will return reversed string of digits, excluding sign.
-         * Reason for returning string is that integer values
-         * cannot keep zeros, eg: 007 will be stored as 7 in an integer.
-         * Exluded sign to simplify internal logic.
-         * @param in Input integer
-         * @return string Reversed integer result.
-         *
-         */
-        template <typename T>
-        static string reverseDigits(const T &in)
-        {
-            // Perform assertions, error checking, or throw
-            if (std::isnan(in))
-                return "";
-            if (!std::numeric_limits<T>::is_integer)
-                return "";
-            if (in == 0)
-                return "0";
-
-            T in_copy = std::move(in);
-            // Track count of post zeros, eg: 1000 would be 3 zeros. Will be added at the end
-            unsigned count = 0;
-            while (in_copy % 10 == 0)
-            {
-                count++;
-                in_copy /= 10;
-            }
-
-            long long reversed_number = 0, remainder;
-            T input = std::move(in);
-            // Reverse numbers using remainder arithmetic
-            while (input != 0)
-            {
-                remainder = input % 10;
-                reversed_number = reversed_number * 10 + remainder;
-                input /= 10;
-            }
-
-            string out = to_string(reversed_number);
-
-            // Account for zeros and prepend all
-            while (count-- > 0)
-                out = "0" + out;
-            return out;
-        }
-    };
-
-    template <typename T>
-    void checkReverseDigits(const T &min, const T &max)
-    {
-        T value = min;
-        for (;;)
-        {
-            long long value_pos = static_cast<long long>(value);
-            // Cast to positive to work with positive values
-            if (value < 0)
-            {
-                value_pos = -value_pos;
-            }
-            // Reverse integer using string
-            string expected = to_string(value_pos);
-            reverse(expected.begin(), expected.end());
-
-            // Reverse digits and assert
-            string actual = Numerics::reverseDigits(value_pos);
-            ASSERT_EQ(expected, actual);
-            if (value++ == max)
-                break;
-        }
-    }
-
-    TEST(NumericsTests, NumericsReverseDigitsShort)
-    {
-        checkReverseDigits(SHRT_MIN, SHRT_MAX);
-    }
-
-    TEST(NumericsTests, NumericsReverseDigitsChar)
-    {
-        checkReverseDigits(CHAR_MIN, CHAR_MAX);
-    }
-
-    // TODO: Very long test. Use sparingly.
-    // TEST(NumericsTests, NumericsReverseDigitsInt)
-    // {
-    //     checkReverseDigits(INT_MIN, INT_MAX);
-    // }
-}
-
-int main(int argc, char **argv)
-{
-    ::testing::InitGoogleTest(&argc, argv);
-    return RUN_ALL_TESTS();
-}
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <limits.h>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include "thread_pool.h"
+
+using namespace std;
+
+namespace Numerics
+{
+    // Compile-time lookup tables shared by reverseDigits and reverseDigitsRecursive
+    namespace tables
+    {
+        struct DigitPairs
+        {
+            char chars[200];     // n = 10a + b -> "ba", the pair already reversed
+            uint8_t values[100]; // n = 10a + b -> 10b + a
+        };
+
+        constexpr DigitPairs makeDigitPairs()
+        {
+            DigitPairs pairs{};
+            for (int n = 0; n < 100; ++n)
+            {
+                pairs.chars[2 * n] = static_cast<char>('0' + n % 10);
+                pairs.chars[2 * n + 1] = static_cast<char>('0' + n / 10);
+                pairs.values[n] = static_cast<uint8_t>(n % 10 * 10 + n / 10);
+            }
+            return pairs;
+        }
+
+        inline constexpr DigitPairs kDigitPairs = makeDigitPairs();
+
+        // Decimal digits of the largest value of U
+        template <typename U>
+        inline constexpr size_t kDigits = std::numeric_limits<U>::digits10 + 1;
+
+        // 10^0 .. 10^kDigits<U>; the last entry wraps modulo 2^N like the rest of the arithmetic
+        template <typename U>
+        constexpr std::array<U, kDigits<U> + 1> makePowersOf10()
+        {
+            std::array<U, kDigits<U> + 1> powers{};
+            U power = 1;
+            for (size_t i = 0; i < powers.size(); ++i)
+            {
+                powers[i] = power;
+                power = static_cast<U>(power * 10);
+            }
+            return powers;
+        }
+
+        template <typename U>
+        inline constexpr std::array<U, kDigits<U> + 1> kPowersOf10 = makePowersOf10<U>();
+    }
+
+    class Numerics
+    {
+    public:
+        /**
+         * Reverses digits given an input integer, keeping its sign: -123 -> -321.
+         * Returns out * 10^(digits of in) + reversed digits of in, the value the original
+         * accumulator recursion produced. Trailing zeros are lost (1200 -> 21); use reverseDigits
+         * to keep them. Results that do not fit in T wrap modulo 2^N instead of overflowing.
+         *
+         * Iterative and constexpr despite the name: the magnitude is reversed two digits per step
+         * through the digit-pair table, in a loop unrolled at compile time to exactly as many steps
+         * as the widest value of T needs.
+         * @param in Input integer
+         * @param out Already reversed digits to prepend
+         * @return T Reversed integer result.
+         */
+        template <typename T>
+        static constexpr T reverseDigitsRecursive(T in, T out = 0)
+        {
+            static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "reverseDigitsRecursive needs an integer type");
+            using U = std::make_unsigned_t<T>;
+            bool negative = false;
+            if constexpr (std::is_signed_v<T>)
+            {
+                negative = in < 0;
+            }
+            const U magnitude = negative ? static_cast<U>(0 - static_cast<U>(in)) : static_cast<U>(in);
+            U reversed = reversePairs(magnitude, std::make_index_sequence<(tables::kDigits<U> - 1) / 2>());
+            if (negative)
+            {
+                reversed = static_cast<U>(0 - reversed);
+            }
+            return static_cast<T>(static_cast<U>(static_cast<U>(out) * tables::kPowersOf10<U>[digitCount(magnitude)] + reversed));
+        }
+
+        // The accumulator recursion this replaced: one call and one division per digit, and signed
+        // overflow on long reversals, which is why the microbenchmark runs it on unsigned widths only.
+        template <typename T>
+        static T reverseDigitsRecursiveLegacy(const T &in, const T &out = 0)
+        {
+            const T input = std::move(in);
+            if (input == 0)
+            {
+                return out;
+            }
+            const T &rem = input % 10;
+            return reverseDigitsRecursiveLegacy((input - rem) / 10, out * 10 + rem);
+        }
+
+        /**
+         * Reverses digits given an input integer. Non-recursive.
+         * Note: Will return reversed string of digits, excluding sign.
+         * Reason for returning string is that integer values
+         * cannot keep zeros, eg: 007 will be stored as 7 in an integer.
+         * Exluded sign to simplify internal logic.
+         * @param in Input integer
+         * @return string Reversed integer result, empty for non-integer types.
+         *
+         */
+        template <typename T>
+        static string reverseDigits(const T &in)
+        {
+            if constexpr (!std::numeric_limits<T>::is_integer)
+            {
+                return "";
+            }
+            else
+            {
+                char buffer[kMaxDigits];
+                const auto result = reverseDigitsTo(buffer, buffer + kMaxDigits, in);
+                return string(buffer, result.ptr);
+            }
+        }
+
+        /**
+         * to_chars-style reverseDigits: writes the reversed digits of |in| (no sign, trailing zeros
+         * kept as leading ones, e.g. 1200 -> "0021") to [first, last) and never allocates.
+         * Returns the end of the written range, or {last, errc::value_too_large} if it does not fit.
+         *
+         * Digits come out of a 2-digit lookup table, least significant pair first, so the output is
+         * produced in reversed order directly into a stack buffer: one division by 100 per two
+         * digits and no separate reverse or zero-counting pass.
+         */
+        template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+        static std::to_chars_result reverseDigitsTo(char *first, char *last, T in)
+        {
+            char digits[kMaxDigits];
+            const size_t length = writeReversed(digits, magnitude(in));
+            if (static_cast<size_t>(last - first) < length)
+            {
+                return {last, std::errc::value_too_large};
+            }
+            std::memcpy(first, digits, length);
+            return {first + length, std::errc()};
+        }
+
+        // Longest output: the 20 digits of UINT64_MAX
+        static constexpr size_t kMaxDigits = 20;
+
+    private:
+        // |in| as unsigned, well defined for the most negative value too
+        template <typename T>
+        static uint64_t magnitude(T in)
+        {
+            if constexpr (std::is_signed_v<T>)
+            {
+                return in < 0 ? 0 - static_cast<uint64_t>(static_cast<int64_t>(in)) : static_cast<uint64_t>(in);
+            }
+            else
+            {
+                return static_cast<uint64_t>(in);
+            }
+        }
+
+        // Write the digits of value least significant first; returns how many
+        static size_t writeReversed(char *out, uint64_t value)
+        {
+            char *p = out;
+            while (value >= 100)
+            {
+                std::memcpy(p, tables::kDigitPairs.chars + 2 * (value % 100), 2);
+                value /= 100;
+                p += 2;
+            }
+            if (value >= 10)
+            {
+                std::memcpy(p, tables::kDigitPairs.chars + 2 * value, 2);
+                p += 2;
+            }
+            else
+            {
+                *p++ = static_cast<char>('0' + value);
+            }
+            return static_cast<size_t>(p - out);
+        }
+
+        // Reverse value two digits per step; one unrolled step per Step while 3+ digits remain
+        template <typename U, size_t... Step>
+        static constexpr U reversePairs(U value, std::index_sequence<Step...>)
+        {
+            U reversed = 0;
+            (void)(... && ((void)Step, value >= 100 && (reversed = static_cast<U>(reversed * 100 + tables::kDigitPairs.values[value % 100]),
+                                                        value = static_cast<U>(value / 100), true)));
+            if (value >= 10)
+            {
+                return static_cast<U>(reversed * 100 + tables::kDigitPairs.values[value]);
+            }
+            return static_cast<U>(reversed * 10 + value);
+        }
+
+        template <typename U>
+        static constexpr size_t digitCount(U value)
+        {
+            size_t digits = value != 0;
+            for (size_t i = 1; i < tables::kDigits<U>; ++i)
+            {
+                digits += value >= tables::kPowersOf10<U>[i];
+            }
+            return digits;
+        }
+
+    public:
+        // Pre-table reverseDigits: counts trailing zeros, reverses into a long long, then prepends
+        // one "0" at a time. Wrong for negative input, so tests and benchmarks feed it |value|.
+        template <typename T>
+        static string reverseDigitsLegacy(const T &in)
+        {
+            if (!std::numeric_limits<T>::is_integer)
+                return "";
+            if (in == 0)
+                return "0";
+
+            T in_copy = std::move(in);
+            // Track count of post zeros, eg: 1000 would be 3 zeros. Will be added at the end
+            unsigned count = 0;
+            while (in_copy % 10 == 0)
+            {
+                count++;
+                in_copy /= 10;
+            }
+
+            long long reversed_number = 0, remainder;
+            T input = std::move(in);
+            // Reverse numbers using remainder arithmetic
+            while (input != 0)
+            {
+                remainder = input % 10;
+                reversed_number = reversed_number * 10 + remainder;
+                input /= 10;
+            }
+
+            string out = to_string(reversed_number);
+
+            // Account for zeros and prepend all
+            while (count-- > 0)
+                out = "0" + out;
+            return out;
+        }
+    };
+
+    template <typename T>
+    void checkReverseDigits(const T &min, const T &max)
+    {
+        T value = min;
+        for (;;)
+        {
+            long long value_pos = static_cast<long long>(value);
+            // Cast to positive to work with positive values
+            if (value < 0)
+            {
+                value_pos = -value_pos;
+            }
+            // Reverse integer using string
+            string expected = to_string(value_pos);
+            reverse(expected.begin(), expected.end());
+
+            // Reverse digits and assert
+            string actual = Numerics::reverseDigits(value_pos);
+            ASSERT_EQ(expected, actual);
+            if (value++ == max)
+                break;
+        }
+    }
+
+    struct VerifyResult
+    {
+        uint64_t checked = 0;
+        uint64_t mismatches = 0;
+        string firstMismatch; // value whose reversal was wrong, empty if none
+        double seconds = 0;
+
+        double valuesPerSecond() const { return seconds > 0 ? checked / seconds : 0; }
+    };
+
+    /**
+     * Parallel version of checkReverseDigits: checks reverseDigitsTo(value) for every stride-th
+     * value in [min, max] (plus max itself) against a to_chars-then-reverse oracle. The index
+     * range is split into one chunk per pool worker; each chunk reuses its own stack buffers and
+     * only counts mismatches, so workers share nothing until the results are merged.
+     * Stride 1 over a full 64-bit range would be 2^64 values, which cannot be counted; that call
+     * checks nothing and returns checked == 0.
+     */
+    template <typename T>
+    VerifyResult checkReverseDigitsParallel(T min, T max, ThreadPool &pool, uint64_t stride = 1)
+    {
+        using U = std::make_unsigned_t<T>;
+        const uint64_t span = static_cast<uint64_t>(static_cast<U>(max) - static_cast<U>(min));
+        if (stride == 0 || (stride == 1 && span == UINT64_MAX))
+        {
+            return {};
+        }
+        const uint64_t steps = span / stride + 1;
+        vector<VerifyResult> partial(pool.chunks(steps));
+
+        auto start = chrono::steady_clock::now();
+        pool.parallelFor(steps, [&](size_t begin, size_t end, size_t chunk)
+                         {
+            VerifyResult &result = partial[chunk];
+            char expected[Numerics::kMaxDigits];
+            char actual[Numerics::kMaxDigits];
+            auto check = [&](T value)
+            {
+                const U magnitude = value < 0 ? static_cast<U>(0 - static_cast<U>(value)) : static_cast<U>(value);
+                char *expectedEnd = to_chars(expected, expected + sizeof(expected), magnitude).ptr;
+                std::reverse(expected, expectedEnd);
+                char *actualEnd = Numerics::reverseDigitsTo(actual, actual + sizeof(actual), value).ptr;
+                const bool same = expectedEnd - expected == actualEnd - actual &&
+                                  memcmp(expected, actual, expectedEnd - expected) == 0;
+                if (!same && result.mismatches++ == 0)
+                {
+                    result.firstMismatch = to_string(value);
+                }
+                ++result.checked;
+            };
+            U value = static_cast<U>(min) + static_cast<U>(begin * stride);
+            for (size_t i = begin; i < end; ++i, value += static_cast<U>(stride))
+            {
+                check(static_cast<T>(value));
+            }
+            if (end == steps && span % stride != 0)
+            {
+                check(max); // the stride may step over the upper bound
+            } });
+
+        VerifyResult total;
+        for (const VerifyResult &result : partial)
+        {
+            total.checked += result.checked;
+            total.mismatches += result.mismatches;
+            if (total.firstMismatch.empty())
+            {
+                total.firstMismatch = result.firstMismatch;
+            }
+        }
+        total.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return total;
+    }
+
+    // Run checkReverseDigitsParallel over [min, max] and report throughput. For types up to 32 bits
+    // the stride is 1 when NUMERICS_EXHAUSTIVE is set (2^32 values for int takes minutes); wider
+    // types always use defaultStride, as exhausting them is out of reach.
+    template <typename T>
+    void verifyReverseDigits(T min, T max, uint64_t defaultStride, const char *label)
+    {
+        ThreadPool pool;
+        const uint64_t stride = sizeof(T) <= 4 && getenv("NUMERICS_EXHAUSTIVE") ? 1 : defaultStride;
+        const VerifyResult result = checkReverseDigitsParallel(min, max, pool, stride);
+        EXPECT_GT(result.checked, 0u);
+        EXPECT_EQ(result.mismatches, 0u) << "first mismatch at " << result.firstMismatch;
+        cout << "Run time (" << label << ", stride " << stride << ", " << pool.size() << " threads): "
+             << result.checked << " values in " << result.seconds << "s, "
+             << static_cast<uint64_t>(result.valuesPerSecond()) << " values/s" << endl;
+    }
+
+    TEST(NumericsTests, NumericsReverseDigitsShort)
+    {
+        checkReverseDigits(SHRT_MIN, SHRT_MAX);
+    }
+
+    TEST(NumericsTests, NumericsReverseDigitsChar)
+    {
+        checkReverseDigits(CHAR_MIN, CHAR_MAX);
+    }
+
+    // Evaluated by the compiler, so these fail the build rather than the test run
+    static_assert(Numerics::reverseDigitsRecursive(1234) == 4321);
+    static_assert(Numerics::reverseDigitsRecursive(-1234) == -4321);
+    static_assert(Numerics::reverseDigitsRecursive(1200) == 21);
+    static_assert(Numerics::reverseDigitsRecursive(0) == 0);
+    static_assert(Numerics::reverseDigitsRecursive(34, 12) == 1243);
+    static_assert(Numerics::reverseDigitsRecursive(static_cast<uint8_t>(123)) == 321 % 256);
+    static_assert(Numerics::reverseDigitsRecursive(18446744073709551615ULL) == 14722102589625661249ULL); // 51615590737044764481 mod 2^64
+
+    TEST(NumericsTests, NumericsReverseDigitsRecursive)
+    {
+        // Same results as the recursion wherever that one did not overflow
+        for (int value = 0; value <= UINT16_MAX; ++value)
+        {
+            ASSERT_EQ(Numerics::reverseDigitsRecursive(static_cast<uint16_t>(value)),
+                      Numerics::reverseDigitsRecursiveLegacy(static_cast<uint16_t>(value)))
+                << value;
+        }
+        for (int value = -99999; value <= 99999; ++value)
+        {
+            ASSERT_EQ(Numerics::reverseDigitsRecursive(value), Numerics::reverseDigitsRecursiveLegacy(value)) << value;
+        }
+        uint64_t state = 88172645463325252ULL;
+        for (int i = 0; i < 100000; ++i)
+        {
+            state ^= state << 13, state ^= state >> 7, state ^= state << 17;
+            ASSERT_EQ(Numerics::reverseDigitsRecursive(state), Numerics::reverseDigitsRecursiveLegacy(state)) << state;
+            const uint32_t narrow = static_cast<uint32_t>(state);
+            ASSERT_EQ(Numerics::reverseDigitsRecursive(narrow), Numerics::reverseDigitsRecursiveLegacy(narrow)) << narrow;
+        }
+        EXPECT_EQ(Numerics::reverseDigitsRecursive(INT_MAX - 9), -226087180); // 8363847412 wraps modulo 2^32
+        EXPECT_EQ(Numerics::reverseDigitsRecursive(static_cast<signed char>(-128)), static_cast<signed char>(-821 % 256));
+        EXPECT_EQ(Numerics::reverseDigitsRecursive(LLONG_MIN + 1), -7085774586302733229LL);
+    }
+
+    // Throughput per width: the unrolled pair version against the one-call-per-digit recursion.
+    // Unsigned widths only for the recursion, where overflowing intermediate results are defined.
+    template <typename T>
+    void benchmarkReverseDigitsRecursive(const char *label, size_t count)
+    {
+        using namespace std::chrono;
+        vector<T> values(count);
+        uint64_t state = 88172645463325252ULL;
+        for (T &value : values)
+        {
+            state ^= state << 13, state ^= state >> 7, state ^= state << 17;
+            value = static_cast<T>(state >> (state & 63)); // mix of short and long values
+        }
+        auto run = [&](auto &&reverse)
+        {
+            T sum = 0;
+            auto start = steady_clock::now();
+            for (T value : values)
+            {
+                sum = static_cast<T>(sum + reverse(value));
+            }
+            double seconds = duration<double>(steady_clock::now() - start).count();
+            return make_pair(static_cast<uint64_t>(count / seconds), sum);
+        };
+        auto unrolled = run([](T value)
+                            { return Numerics::reverseDigitsRecursive(value); });
+        auto legacy = run([](T value)
+                          { return Numerics::reverseDigitsRecursiveLegacy(value); });
+        EXPECT_EQ(unrolled.second, legacy.second);
+        cout << "Run time (" << label << ", " << count << " values): unrolled " << unrolled.first
+             << " values/s, recursive " << legacy.first << " values/s" << endl;
+    }
+
+    TEST(NumericsTests, NumericsReverseDigitsRecursiveBenchmark)
+    {
+        const size_t count = 1 << 20;
+        benchmarkReverseDigitsRecursive<uint8_t>("uint8", count);
+        benchmarkReverseDigitsRecursive<uint16_t>("uint16", count);
+        benchmarkReverseDigitsRecursive<uint32_t>("uint32", count);
+        benchmarkReverseDigitsRecursive<uint64_t>("uint64", count);
+    }
+
+    TEST(NumericsTests, NumericsReverseDigitsTo)
+    {
+        EXPECT_EQ(Numerics::reverseDigits(0), "0");
+        EXPECT_EQ(Numerics::reverseDigits(7), "7");
+        EXPECT_EQ(Numerics::reverseDigits(1200), "0021");
+        EXPECT_EQ(Numerics::reverseDigits(-1200), "0021"); // sign excluded
+        EXPECT_EQ(Numerics::reverseDigits(INT_MIN), "8463847412");
+        EXPECT_EQ(Numerics::reverseDigits(LLONG_MIN), "8085774586302733229");
+        EXPECT_EQ(Numerics::reverseDigits(ULLONG_MAX), "51615590737044764481");
+        EXPECT_EQ(Numerics::reverseDigits((unsigned char)200), "002");
+        EXPECT_EQ(Numerics::reverseDigits(1.5), "");
+
+        char buffer[Numerics::kMaxDigits];
+        auto result = Numerics::reverseDigitsTo(buffer, buffer + sizeof(buffer), 123456789);
+        EXPECT_EQ(result.ec, std::errc());
+        EXPECT_EQ(string(buffer, result.ptr), "987654321");
+        result = Numerics::reverseDigitsTo(buffer, buffer + 3, 1234);
+        EXPECT_EQ(result.ec, std::errc::value_too_large);
+        EXPECT_EQ(result.ptr, buffer + 3);
+        result = Numerics::reverseDigitsTo(buffer, buffer + 4, 1234);
+        EXPECT_EQ(string(buffer, result.ptr), "4321");
+
+        // Agrees with the legacy version wherever that one was right (non-negative values)
+        for (long long value : {1LL, 10LL, 99LL, 100LL, 101LL, 1000000LL, 987654321012LL, LLONG_MAX})
+        {
+            EXPECT_EQ(Numerics::reverseDigits(value), Numerics::reverseDigitsLegacy(value)) << value;
+        }
+    }
+
+    // Benchmark: legacy vs table-driven string API vs the non-allocating API over the int32
+    // range, sampled with a stride of 4099 by default; NUMERICS_BENCH_FULL=1 visits all 2^32.
+    TEST(NumericsTests, NumericsReverseDigitsBenchmark)
+    {
+        using namespace std::chrono;
+        const int64_t stride = getenv("NUMERICS_BENCH_FULL") ? 1 : 4099;
+        auto run = [&](auto &&reverse)
+        {
+            size_t checksum = 0;
+            auto start = high_resolution_clock::now();
+            for (int64_t value = INT_MIN; value <= INT_MAX; value += stride)
+            {
+                checksum += reverse((int)value);
+            }
+            auto us = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+            return make_pair(us, checksum);
+        };
+        // The legacy version only handles non-negative input correctly, so it gets |value|
+        auto legacy = run([](int value)
+                          { return Numerics::reverseDigitsLegacy(llabs((long long)value)).size(); });
+        auto table = run([](int value)
+                         { return Numerics::reverseDigits(value).size(); });
+        auto noAlloc = run([](int value)
+                           {
+            char buffer[Numerics::kMaxDigits];
+            return (size_t)(Numerics::reverseDigitsTo(buffer, buffer + sizeof(buffer), value).ptr - buffer); });
+        EXPECT_EQ(legacy.second, table.second);
+        EXPECT_EQ(noAlloc.second, table.second);
+        cout << "Run time (int32 range, stride " << stride << "): legacy " << legacy.first << "us, table string "
+             << table.first << "us, table to_chars-style " << noAlloc.first << "us" << endl;
+    }
+
+    // Every int with NUMERICS_EXHAUSTIVE=1; a stride coprime to 10 otherwise, so that all digit
+    // lengths and trailing digits are still covered.
+    TEST(NumericsTests, NumericsReverseDigitsInt)
+    {
+        verifyReverseDigits(INT_MIN, INT_MAX, 1021, "int32");
+    }
+
+    // Always sampled, with strides coprime to 10 like the int32 one
+    TEST(NumericsTests, NumericsReverseDigitsLong)
+    {
+        verifyReverseDigits(LLONG_MIN, LLONG_MAX, 4611686018427ULL, "int64");
+        verifyReverseDigits(0ULL, ULLONG_MAX, 9223372036857ULL, "uint64");
+        // Trailing zeros and the ends of the range are where the modulo version went wrong
+        ThreadPool pool;
+        EXPECT_EQ(checkReverseDigitsParallel(0ULL, ULLONG_MAX, pool).checked, 0u); // 2^64 values: refused
+        EXPECT_EQ(checkReverseDigitsParallel(LLONG_MAX - 100000, LLONG_MAX, pool).mismatches, 0u);
+        EXPECT_EQ(checkReverseDigitsParallel(LLONG_MIN, LLONG_MIN + 100000, pool).mismatches, 0u);
+        EXPECT_EQ(checkReverseDigitsParallel(-1000000LL, 1000000LL, pool).mismatches, 0u);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
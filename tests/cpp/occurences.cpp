@@ -1,8 +1,24 @@
 #include <gtest/gtest.h>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 #include <iostream>
 
+#include "flat_hash_map.h"
+#include "thread_pool.h"
+
 using namespace std;
 
 void printOccurrences(int *arr, int n)
@@ -12,56 +28,559 @@ void printOccurrences(int *arr, int n)
         return;
     }
 
-    unordered_map<int, int> map;
+    FlatHashMap<int, int> map;
+    map.reserve(n);
     for (int i = 0; i < n; ++i)
     {
         map[arr[i]]++;
     }
 }
 
-set<int> unique(int *arr, int n)
+// The std::set implementation unique() had before it returned a sorted vector: one node
+// allocation per distinct value. UniqueBenchmark times it next to the sort, radix and hash versions.
+set<int> uniqueWithSet(const int *arr, int n)
 {
     if (arr == nullptr)
     {
         return set<int>({});
     }
-    int unique[] = {};
-    return set<int>(arr, arr + n);;
+    return set<int>(arr, arr + n);
+}
+
+// Sorted distinct values: sort a copy, then drop adjacent repeats
+vector<int> uniqueSorted(const int *arr, size_t n)
+{
+    vector<int> values(arr, arr + n);
+    sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+}
+
+/**
+ * Sorted distinct values with an LSD radix sort: four stable counting passes over 8-bit digits
+ * (the sign bit flipped so negatives order first) instead of comparisons, then drop adjacent
+ * repeats. Passes whose digit is the same for every value are skipped.
+ */
+vector<int> uniqueRadix(const int *arr, size_t n)
+{
+    vector<uint32_t> keys(n), scratch(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        keys[i] = static_cast<uint32_t>(arr[i]) ^ 0x80000000u;
+    }
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        size_t offsets[257] = {0};
+        for (uint32_t key : keys)
+        {
+            offsets[((key >> shift) & 0xFF) + 1]++;
+        }
+        if (n > 0 && offsets[((keys[0] >> shift) & 0xFF) + 1] == n)
+        {
+            continue;
+        }
+        for (int digit = 0; digit < 256; ++digit)
+        {
+            offsets[digit + 1] += offsets[digit];
+        }
+        for (uint32_t key : keys)
+        {
+            scratch[offsets[(key >> shift) & 0xFF]++] = key;
+        }
+        keys.swap(scratch);
+    }
+    vector<int> values;
+    values.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (i == 0 || keys[i] != keys[i - 1])
+        {
+            values.push_back(static_cast<int>(keys[i] ^ 0x80000000u));
+        }
+    }
+    return values;
+}
+
+// Distinct values in order of first occurrence, without sorting
+vector<int> uniqueUnordered(const int *arr, size_t n)
+{
+    FlatHashMap<int, bool> seen;
+    vector<int> values;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (seen.try_emplace(arr[i], true).second)
+        {
+            values.push_back(arr[i]);
+        }
+    }
+    return values;
 }
 
-set<int> unique(const vector<int> &vec)
+// Sorted distinct values; radix sort once the input is large enough to amortize its passes
+vector<int> unique(int *arr, int n)
+{
+    if (arr == nullptr || n <= 0)
+    {
+        return {};
+    }
+    return n < 4096 ? uniqueSorted(arr, n) : uniqueRadix(arr, n);
+}
+
+vector<int> unique(const vector<int> &vec)
 {
     if (vec.empty())
     {
-        return set<int>({});
+        return {};
+    }
+    return vec.size() < 4096 ? uniqueSorted(vec.data(), vec.size()) : uniqueRadix(vec.data(), vec.size());
+}
+
+/**
+ * HyperLogLog cardinality estimate for streams too large to keep the distinct values: 2^precision
+ * one-byte registers, about 1.04 / sqrt(2^precision) relative error (0.8% at the default 14,
+ * using 16 KiB). Uses linear counting while many registers are still zero.
+ */
+class HyperLogLog
+{
+public:
+    explicit HyperLogLog(int precision = 14) : precision(max(4, min(precision, 18))), registers(size_t(1) << this->precision, 0) {}
+
+    template <typename T>
+    void add(const T &value)
+    {
+        addHash(mix(static_cast<uint64_t>(std::hash<T>{}(value))));
+    }
+
+    // Register index from the top bits, rank of the first set bit in the rest
+    void addHash(uint64_t hash)
+    {
+        const size_t index = hash >> (64 - precision);
+        const uint64_t rest = hash << precision;
+        const uint8_t rank = rest == 0 ? static_cast<uint8_t>(64 - precision + 1) : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+        registers[index] = max(registers[index], rank);
+    }
+
+    // Combine with another estimator of the same precision, e.g. one per thread
+    void merge(const HyperLogLog &other)
+    {
+        for (size_t i = 0; i < registers.size(); ++i)
+        {
+            registers[i] = max(registers[i], other.registers[i]);
+        }
+    }
+
+    double estimate() const
+    {
+        const double m = static_cast<double>(registers.size());
+        double sum = 0;
+        size_t zeros = 0;
+        for (uint8_t rank : registers)
+        {
+            sum += std::ldexp(1.0, -rank);
+            zeros += rank == 0;
+        }
+        const double alpha = 0.7213 / (1 + 1.079 / m);
+        const double raw = alpha * m * m / sum;
+        if (raw <= 2.5 * m && zeros > 0)
+        {
+            return m * std::log(m / zeros);
+        }
+        return raw;
+    }
+
+private:
+    // SplitMix64 finalizer: std::hash of integers is the identity
+    static uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    int precision;
+    vector<uint8_t> registers;
+};
+
+// Key types whose whole domain fits a dense array: counting indexes it instead of hashing
+template <typename T>
+constexpr bool isSmallDomain = std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, uint8_t> ||
+                               std::is_same_v<T, int16_t> || std::is_same_v<T, uint16_t>;
+
+/**
+ * Occurrence counts for a small-domain key type, one slot per possible value. Offers the parts of
+ * the map interface the callers use: find/end, operator[], at, count, size (distinct keys) and
+ * iteration over the keys that occur, in ascending order of their unsigned representation.
+ */
+template <typename T>
+class DenseCounts
+{
+    using Index = std::make_unsigned_t<T>;
+    static constexpr size_t kDomain = size_t(1) << (8 * sizeof(T));
+
+public:
+    class Iterator
+    {
+    public:
+        const pair<T, int> &operator*() const { return entry; }
+        const pair<T, int> *operator->() const { return &entry; }
+        Iterator &operator++()
+        {
+            index = counts->next(index + 1);
+            load();
+            return *this;
+        }
+        bool operator==(const Iterator &other) const { return index == other.index; }
+        bool operator!=(const Iterator &other) const { return index != other.index; }
+
+    private:
+        friend class DenseCounts;
+        Iterator(const DenseCounts *counts, size_t index) : counts(counts), index(index) { load(); }
+        void load()
+        {
+            if (index < kDomain)
+            {
+                entry = {static_cast<T>(static_cast<Index>(index)), counts->values[index]};
+            }
+        }
+
+        const DenseCounts *counts;
+        size_t index;
+        pair<T, int> entry;
+    };
+
+    DenseCounts() : values(kDomain, 0) {}
+
+    Iterator begin() const { return Iterator(this, next(0)); }
+    Iterator end() const { return Iterator(this, kDomain); }
+    Iterator find(T key) const { return values[slot(key)] ? Iterator(this, slot(key)) : end(); }
+    size_t count(T key) const { return values[slot(key)] != 0; }
+    int &operator[](T key) { return values[slot(key)]; }
+    int at(T key) const
+    {
+        if (!values[slot(key)])
+        {
+            throw out_of_range("DenseCounts::at: key not found");
+        }
+        return values[slot(key)];
+    }
+    size_t size() const { return kDomain - std::count(values.begin(), values.end(), 0); }
+
+    // Raw counts indexed by the key's unsigned representation
+    int *data() { return values.data(); }
+
+    void merge(const DenseCounts &other)
+    {
+        for (size_t i = 0; i < kDomain; ++i)
+        {
+            values[i] += other.values[i];
+        }
+    }
+
+private:
+    static size_t slot(T key) { return static_cast<Index>(key); }
+    size_t next(size_t index) const
+    {
+        while (index < kDomain && values[index] == 0)
+        {
+            ++index;
+        }
+        return index;
+    }
+
+    vector<int> values;
+};
+
+/**
+ * Histogram of count keys into counts (indexed by unsigned representation). A run of equal keys
+ * makes every increment wait for the previous store to the same slot, so the loop rotates
+ * through Lanes separate sub-histograms and sums them at the end; with bytes, 4 lanes of 256
+ * counters stay in L1.
+ */
+template <typename T, size_t Lanes>
+void denseHistogram(const T *keys, size_t count, int *counts)
+{
+    using Index = std::make_unsigned_t<T>;
+    constexpr size_t domain = size_t(1) << (8 * sizeof(T));
+    vector<uint32_t> storage(Lanes * domain, 0);
+    uint32_t *lanes = storage.data();
+    // Sub-counts are 32-bit; flush before any of them could wrap
+    const size_t block = size_t(1) << 31;
+    for (size_t begin = 0; begin < count; begin += block)
+    {
+        const size_t end = min(count, begin + block);
+        size_t i = begin;
+        if constexpr (sizeof(T) == 1 && Lanes == 4)
+        {
+            // Bytes: one 8-byte load feeds two increments per lane
+            for (; i + 8 <= end; i += 8)
+            {
+                uint64_t word;
+                memcpy(&word, keys + i, sizeof(word));
+                lanes[0 * domain + (word & 0xFF)]++;
+                lanes[1 * domain + ((word >> 8) & 0xFF)]++;
+                lanes[2 * domain + ((word >> 16) & 0xFF)]++;
+                lanes[3 * domain + ((word >> 24) & 0xFF)]++;
+                lanes[0 * domain + ((word >> 32) & 0xFF)]++;
+                lanes[1 * domain + ((word >> 40) & 0xFF)]++;
+                lanes[2 * domain + ((word >> 48) & 0xFF)]++;
+                lanes[3 * domain + (word >> 56)]++;
+            }
+        }
+        for (; i + Lanes <= end; i += Lanes)
+        {
+            for (size_t lane = 0; lane < Lanes; ++lane)
+            {
+                lanes[lane * domain + static_cast<Index>(keys[i + lane])]++;
+            }
+        }
+        for (; i < end; ++i)
+        {
+            lanes[static_cast<Index>(keys[i])]++;
+        }
+        for (size_t lane = 0; lane < Lanes; ++lane)
+        {
+            for (size_t value = 0; value < domain; ++value)
+            {
+                counts[value] += static_cast<int>(lanes[lane * domain + value]);
+                lanes[lane * domain + value] = 0;
+            }
+        }
     }
-    int unique[] = {};
-    return set<int>(vec.begin(), vec.end());
 }
 
 /**
  * Count occurences and remove duplicates in place without copies of vector
  */
 template <typename T>
-std::unordered_map<T, int> countOccurencesAndRemoveDuplicates(vector<T> &vec)
-{
-    std::unordered_map<T, int> map;
-
-    // Iterate over the vector to count occurrences and remove duplicates
-    vec.erase(std::remove_if(vec.begin(), vec.end(), [&](T c)
-                             {
-        if (map[c] > 0) {
-            return true; // remove duplicate
-        } else {
-            map[c]++;
-            return false;
-        } }),
-              vec.end());
-    return map;
+auto countOccurencesAndRemoveDuplicates(vector<T> &vec)
+{
+    if constexpr (isSmallDomain<T>)
+    {
+        // A dense first-seen table instead of hashing
+        DenseCounts<T> map;
+        vec.erase(std::remove_if(vec.begin(), vec.end(), [&](T c)
+                                 {
+            int &seen = map[c];
+            if (seen > 0) {
+                return true; // remove duplicate
+            }
+            seen = 1;
+            return false; }),
+                  vec.end());
+        return map;
+    }
+    else
+    {
+        FlatHashMap<T, int> map;
+
+        // Iterate over the vector to count occurrences and remove duplicates.
+        // try_emplace finds or inserts with one probe: a duplicate is any key that was already there.
+        vec.erase(std::remove_if(vec.begin(), vec.end(), [&](T c)
+                                 { return !map.try_emplace(c, 1).second; }),
+                  vec.end());
+        return map;
+    }
+}
+
+// Counts per distinct value: a dense array for char, uint8_t and 16-bit keys, a hash map otherwise
+template <typename T>
+auto countDuplicates(const vector<T> &vec)
+{
+    if constexpr (isSmallDomain<T>)
+    {
+        DenseCounts<T> map;
+        denseHistogram<T, sizeof(T) == 1 ? 4 : 2>(vec.data(), vec.size(), map.data());
+        return map;
+    }
+    else
+    {
+        FlatHashMap<T, int> map;
+        for (const auto &item : vec)
+        {
+            map[item]++;
+        }
+        return map;
+    }
+}
+
+/**
+ * Merge parts[1..] into parts[0] pairwise in log2(n) rounds: round r merges parts[i + 2^r] into
+ * parts[i] for every i that is a multiple of 2^(r+1), with the merges of a round running on pool.
+ * merge(into, from) must fold a later part into an earlier one.
+ */
+template <typename Part, typename Merge>
+void reduceTree(vector<Part> &parts, ThreadPool &pool, Merge merge)
+{
+    for (size_t stride = 1; stride < parts.size(); stride *= 2)
+    {
+        vector<future<void>> round;
+        for (size_t i = 0; i + stride < parts.size(); i += 2 * stride)
+        {
+            round.push_back(pool.submit([&parts, &merge, i, stride]
+                                        { merge(parts[i], parts[i + stride]); }));
+        }
+        for (auto &merged : round)
+        {
+            merged.get();
+        }
+    }
+}
+
+template <typename T>
+void mergeCounts(FlatHashMap<T, int> &into, const FlatHashMap<T, int> &from)
+{
+    for (const auto &[key, count] : from)
+    {
+        into[key] += count;
+    }
+}
+
+template <typename T>
+void mergeCounts(DenseCounts<T> &into, const DenseCounts<T> &from)
+{
+    into.merge(from);
+}
+
+/**
+ * countDuplicates on a thread pool: each worker counts its contiguous slice into a local map (or
+ * dense array for small-domain keys) and the locals are combined with a tree reduction, so no
+ * counter is ever shared between threads.
+ */
+template <typename T>
+auto countDuplicatesParallel(const vector<T> &vec, ThreadPool &pool)
+{
+    using Counts = decltype(countDuplicates(vec));
+    vector<Counts> partial(pool.chunks(vec.size()));
+    pool.parallelFor(vec.size(), [&](size_t begin, size_t end, size_t chunk)
+                     {
+        if constexpr (isSmallDomain<T>)
+        {
+            denseHistogram<T, sizeof(T) == 1 ? 4 : 2>(vec.data() + begin, end - begin, partial[chunk].data());
+        }
+        else
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                partial[chunk][vec[i]]++;
+            }
+        } });
+    reduceTree(partial, pool, [](Counts &into, const Counts &from)
+               { mergeCounts(into, from); });
+    return std::move(partial[0]);
+}
+
+// Index of each key's first occurrence: a hash map in general...
+template <typename T, bool Dense = isSmallDomain<T>>
+class FirstOccurrence
+{
+public:
+    // Indices are recorded in increasing order within one instance, so the first one sticks
+    void record(const T &key, size_t index) { first.try_emplace(key, index); }
+    size_t at(const T &key) const { return first.find(key)->second; }
+    void merge(const FirstOccurrence &later)
+    {
+        for (const auto &[key, index] : later.first)
+        {
+            auto [it, inserted] = first.try_emplace(key, index);
+            if (!inserted)
+            {
+                it->second = min(it->second, index);
+            }
+        }
+    }
+    size_t distinct() const { return first.size(); }
+
+private:
+    FlatHashMap<T, size_t> first;
+};
+
+// ...and a dense array for small-domain keys
+template <typename T>
+class FirstOccurrence<T, true>
+{
+    using Index = std::make_unsigned_t<T>;
+    static constexpr size_t kDomain = size_t(1) << (8 * sizeof(T));
+    static constexpr size_t kNone = SIZE_MAX;
+
+public:
+    FirstOccurrence() : first(kDomain, kNone) {}
+    void record(T key, size_t index)
+    {
+        size_t &slot = first[static_cast<Index>(key)];
+        slot = min(slot, index);
+    }
+    size_t at(T key) const { return first[static_cast<Index>(key)]; }
+    void merge(const FirstOccurrence &later)
+    {
+        for (size_t i = 0; i < kDomain; ++i)
+        {
+            first[i] = min(first[i], later.first[i]);
+        }
+    }
+    size_t distinct() const { return kDomain - std::count(first.begin(), first.end(), kNone); }
+
+private:
+    vector<size_t> first;
+};
+
+/**
+ * Stable parallel dedup: keeps the first occurrence of every value in its original order, like
+ * countOccurencesAndRemoveDuplicates, and returns the number of values kept.
+ *
+ * Workers record the first index of each key in their slice, a tree reduction takes the minimum
+ * per key across slices, and each worker then marks which of its elements are global first
+ * occurrences. A prefix sum over the per-slice kept counts gives every slice its output offset,
+ * so the compaction into the result runs in parallel without locks.
+ */
+template <typename T>
+size_t removeDuplicatesParallel(vector<T> &vec, ThreadPool &pool)
+{
+    const size_t slices = pool.chunks(vec.size());
+    vector<FirstOccurrence<T>> first(slices);
+    pool.parallelFor(vec.size(), [&](size_t begin, size_t end, size_t slice)
+                     {
+        for (size_t i = begin; i < end; ++i)
+        {
+            first[slice].record(vec[i], i);
+        } });
+    reduceTree(first, pool, [](FirstOccurrence<T> &into, const FirstOccurrence<T> &from)
+               { into.merge(from); });
+    const FirstOccurrence<T> &global = first[0];
+
+    vector<uint8_t> keep(vec.size());
+    vector<size_t> kept(slices + 1, 0);
+    pool.parallelFor(vec.size(), [&](size_t begin, size_t end, size_t slice)
+                     {
+        size_t count = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            keep[i] = global.at(vec[i]) == i;
+            count += keep[i];
+        }
+        kept[slice + 1] = count; });
+    partial_sum(kept.begin(), kept.end(), kept.begin());
+
+    vector<T> result(kept[slices]);
+    pool.parallelFor(vec.size(), [&](size_t begin, size_t end, size_t slice)
+                     {
+        size_t out = kept[slice];
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (keep[i])
+            {
+                result[out++] = std::move(vec[i]);
+            }
+        } });
+    vec.swap(result);
+    return vec.size();
 }
 
+// std::unordered_map counting as countDuplicates did it before FlatHashMap and dense histograms;
+// still the expected result in the count tests and the slow line in their benchmark.
 template <typename T>
-unordered_map<T, int> countDuplicates(vector<T> &vec)
+unordered_map<T, int> countDuplicatesUnordered(const vector<T> &vec)
 {
     unordered_map<T, int> map;
     for (const auto &item : vec)
@@ -74,7 +593,7 @@ unordered_map<T, int> countDuplicates(vector<T> &vec)
 TEST(OccurencesTests, CountAndValidateDuplicates)
 {
     vector<char> actual = {'a', 'b', 'c', 'a', 'd', 'b', 'e', 'a', 'c', 'f', 'f', 'f'};
-    unordered_map<char, int> map = countDuplicates(actual);
+    auto map = countDuplicates(actual);
     unordered_map<char, int> expected = {{'a', 3}, {'b', 2}, {'c', 2}, {'d', 1}, {'e', 1}, {'f', 3}};
 
     // Print the elements of the vector without duplicates
@@ -92,7 +611,7 @@ TEST(OccurencesTests, CountOccurencesAndRemoveDuplicates)
 {
     std::vector<char> actual = {'a', 'b', 'c', 'a', 'd', 'b', 'e', 'a', 'c', 'f', 'f', 'f'};
     std::vector<char> expected = {'a', 'b', 'c', 'd', 'e', 'f'};
-    unordered_map<char, int> map = countOccurencesAndRemoveDuplicates(actual);
+    auto map = countOccurencesAndRemoveDuplicates(actual);
 
     // Print the elements of the vector without duplicates
     for (int i = 0; i < expected.size(); ++i)
@@ -101,6 +620,390 @@ TEST(OccurencesTests, CountOccurencesAndRemoveDuplicates)
     }
 }
 
+TEST(OccurencesTests, FlatHashMap)
+{
+    FlatHashMap<int, int> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(1), map.end());
+
+    // Matches std::unordered_map through growth, overwrites and erases
+    unordered_map<int, int> reference;
+    mt19937 engine(42);
+    for (int i = 0; i < 20000; ++i)
+    {
+        const int key = (int)(engine() % 5000) - 2500;
+        switch (engine() % 4)
+        {
+        case 0:
+            EXPECT_EQ(map.erase(key), reference.erase(key));
+            break;
+        case 1:
+            map.insert_or_assign(key, i);
+            reference[key] = i;
+            break;
+        default:
+        {
+            auto [it, inserted] = map.try_emplace(key, i);
+            EXPECT_EQ(inserted, reference.emplace(key, i).second);
+            EXPECT_EQ(it->second, reference[key]);
+        }
+        }
+        ASSERT_EQ(map.size(), reference.size());
+    }
+    size_t visited = 0;
+    for (const auto &[key, value] : map)
+    {
+        EXPECT_EQ(reference.at(key), value);
+        visited++;
+    }
+    EXPECT_EQ(visited, reference.size());
+    for (int key = -2600; key < 2600; ++key)
+    {
+        EXPECT_EQ(map.count(key), reference.count(key));
+    }
+
+    // Copy, move, clear and reserve
+    FlatHashMap<int, int> copy = map;
+    FlatHashMap<int, int> moved = std::move(map);
+    EXPECT_EQ(copy.size(), reference.size());
+    EXPECT_EQ(moved.size(), reference.size());
+    copy.clear();
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(copy.begin(), copy.end());
+    copy.reserve(1000);
+    const size_t capacity = copy.capacity();
+    for (int i = 0; i < 1000; ++i)
+    {
+        copy[i] = i;
+    }
+    EXPECT_EQ(copy.capacity(), capacity);
+    EXPECT_THROW(copy.at(5000), std::out_of_range);
+
+    // Non-trivial keys and values
+    FlatHashMap<string, vector<int>> strings;
+    for (int i = 0; i < 100; ++i)
+    {
+        strings["key" + to_string(i % 10)].push_back(i);
+    }
+    EXPECT_EQ(strings.size(), 10);
+    EXPECT_EQ(strings.at("key3").size(), 10);
+    EXPECT_EQ(strings.erase("key3"), 1);
+    EXPECT_FALSE(strings.contains("key3"));
+}
+
+// Sizes up to 10^6 by default; set FLAT_HASH_MAP_BENCH_MAX_EXP (up to 8) for the larger runs
+TEST(OccurencesTests, FlatHashMapBenchmark)
+{
+    using namespace std::chrono;
+    const char *env = getenv("FLAT_HASH_MAP_BENCH_MAX_EXP");
+    const int maxExponent = env ? min(8, atoi(env)) : 6;
+    mt19937 engine(42);
+    size_t entries = 1000;
+    for (int exponent = 3; exponent <= maxExponent; ++exponent, entries *= 10)
+    {
+        // Each key appears twice on average, in random order
+        vector<int> keys(entries * 2);
+        for (auto &key : keys)
+        {
+            key = (int)(engine() % entries);
+        }
+
+        auto start = high_resolution_clock::now();
+        auto unordered = countDuplicatesUnordered(keys);
+        auto unorderedCountUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        auto flat = countDuplicates(keys);
+        auto flatCountUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        ASSERT_EQ(flat.size(), unordered.size());
+
+        long long unorderedSum = 0, flatSum = 0;
+        start = high_resolution_clock::now();
+        for (int key : keys)
+        {
+            auto it = unordered.find(key);
+            unorderedSum += it == unordered.end() ? 0 : it->second;
+        }
+        auto unorderedFindUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        for (int key : keys)
+        {
+            auto it = flat.find(key);
+            flatSum += it == flat.end() ? 0 : it->second;
+        }
+        auto flatFindUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        EXPECT_EQ(unorderedSum, flatSum);
+
+        cout << "Run time (10^" << exponent << " entries, " << keys.size() << " keys): count unordered_map "
+             << unorderedCountUs << "us, FlatHashMap " << flatCountUs << "us; find unordered_map " << unorderedFindUs
+             << "us, FlatHashMap " << flatFindUs << "us" << endl;
+    }
+}
+
+TEST(OccurencesTests, DenseCounts)
+{
+    // Every small-domain type agrees with the hash map, including negative keys
+    mt19937 engine(43);
+    auto check = [&](auto sample)
+    {
+        using T = decltype(sample);
+        vector<T> values(50000);
+        for (auto &value : values)
+        {
+            value = static_cast<T>(engine() % 600);
+        }
+        values.push_back(numeric_limits<T>::min());
+        values.push_back(numeric_limits<T>::max());
+        auto dense = countDuplicates(values);
+        static_assert(std::is_same_v<decltype(dense), DenseCounts<T>>);
+        const auto expected = countDuplicatesUnordered(values);
+        EXPECT_EQ(dense.size(), expected.size());
+        for (const auto &[key, count] : expected)
+        {
+            ASSERT_NE(dense.find(key), dense.end());
+            EXPECT_EQ(dense.find(key)->second, count);
+            EXPECT_EQ(dense.at(key), count);
+        }
+        size_t visited = 0;
+        for (const auto &[key, count] : dense)
+        {
+            EXPECT_EQ(expected.at(key), count);
+            visited++;
+        }
+        EXPECT_EQ(visited, expected.size());
+    };
+    check(char());
+    check(uint8_t());
+    check(int16_t());
+    check(uint16_t());
+
+    // Other types keep the hash path
+    static_assert(std::is_same_v<decltype(countDuplicates(vector<int>())), FlatHashMap<int, int>>);
+
+    vector<int16_t> values = {-3, 7, -3, 7, 7, 1000, -3};
+    auto firstSeen = countOccurencesAndRemoveDuplicates(values);
+    EXPECT_EQ(values, vector<int16_t>({-3, 7, 1000}));
+    EXPECT_EQ(firstSeen.size(), 3);
+    EXPECT_EQ(firstSeen.at(-3), 1);
+    EXPECT_EQ(firstSeen.count(5), 0);
+}
+
+// Histogram of bytes: hash map vs one dense array vs 4 sub-histograms. 4 MiB by default; set
+// OCCURRENCES_BENCH_MIB=1024 for the 1 GiB run.
+TEST(OccurencesTests, DenseCountsBenchmark)
+{
+    using namespace std::chrono;
+    const char *env = getenv("OCCURRENCES_BENCH_MIB");
+    const size_t size = size_t(env ? atoi(env) : 4) << 20;
+    vector<uint8_t> bytes(size);
+    mt19937 engine(44);
+    // Long runs of one value are the case that serializes a single histogram
+    for (size_t i = 0; i < size;)
+    {
+        const uint8_t value = static_cast<uint8_t>(engine());
+        const size_t run = min<size_t>(size - i, engine() % 64 + 1);
+        std::fill(bytes.begin() + i, bytes.begin() + i + run, value);
+        i += run;
+    }
+
+    auto start = high_resolution_clock::now();
+    FlatHashMap<uint8_t, int> hashed;
+    for (size_t i = 0; i < min<size_t>(size, 16 << 20); ++i) // 16 MiB only: hashing is far slower
+    {
+        hashed[bytes[i]]++;
+    }
+    auto hashUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+
+    auto timeLanes = [&](auto lanes)
+    {
+        vector<int> counts(256, 0);
+        auto begin = high_resolution_clock::now();
+        denseHistogram<uint8_t, decltype(lanes)::value>(bytes.data(), bytes.size(), counts.data());
+        auto us = duration_cast<microseconds>(high_resolution_clock::now() - begin).count();
+        EXPECT_EQ(accumulate(counts.begin(), counts.end(), size_t(0)), size);
+        return us;
+    };
+    auto singleUs = timeLanes(integral_constant<size_t, 1>());
+    auto lanesUs = timeLanes(integral_constant<size_t, 4>());
+    auto gbPerSecond = [&](long long us, size_t bytesRead)
+    { return us == 0 ? 0.0 : bytesRead / 1e3 / us; };
+    cout << "Run time (" << (size >> 20) << " MiB): FlatHashMap " << gbPerSecond(hashUs, min<size_t>(size, 16 << 20))
+         << " GB/s, dense 1 lane " << singleUs << "us (" << gbPerSecond(singleUs, size) << " GB/s), 4 lanes " << lanesUs
+         << "us (" << gbPerSecond(lanesUs, size) << " GB/s)" << endl;
+}
+
+TEST(OccurencesTests, ParallelCountAndDedup)
+{
+    mt19937 engine(44);
+    auto check = [&](auto sample, size_t distinct)
+    {
+        using T = decltype(sample);
+        for (size_t count : {0, 1, 7, 1000, 30000})
+        {
+            vector<T> values(count);
+            for (auto &value : values)
+            {
+                value = static_cast<T>(engine() % distinct);
+            }
+            const auto serial = countDuplicates(values);
+            vector<T> serialDeduped = values;
+            countOccurencesAndRemoveDuplicates(serialDeduped);
+            for (size_t threads : {1, 2, 3, 5})
+            {
+                ThreadPool pool(threads);
+                const auto parallel = countDuplicatesParallel(values, pool);
+                ASSERT_EQ(parallel.size(), serial.size());
+                for (const auto &[key, n] : serial)
+                {
+                    EXPECT_EQ(parallel.at(key), n);
+                }
+                vector<T> deduped = values;
+                EXPECT_EQ(removeDuplicatesParallel(deduped, pool), serialDeduped.size());
+                EXPECT_EQ(deduped, serialDeduped); // first occurrences in original order
+            }
+        }
+    };
+    check(char(), 200);
+    check(int16_t(), 5000);
+    check(int(), 3000);
+    check(int64_t(), 100000);
+}
+
+// Scaling of the parallel count and dedup from 1 thread to all hardware threads. 2^22 elements by
+// default; set OCCURRENCES_BENCH_ELEMENTS=1000000000 for the 1B run (needs ~15 GB for ints).
+TEST(OccurencesTests, ParallelCountAndDedupBenchmark)
+{
+    using namespace std::chrono;
+    const char *env = getenv("OCCURRENCES_BENCH_ELEMENTS");
+    const size_t count = env ? strtoull(env, nullptr, 10) : size_t(1) << 22;
+    mt19937 engine(45);
+    vector<int> ints(count);
+    vector<uint8_t> bytes(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        ints[i] = (int)(engine() % (1 << 20));
+        bytes[i] = static_cast<uint8_t>(ints[i]);
+    }
+
+    cout << "Run time (" << count << " elements):" << endl;
+    const size_t cores = max(1u, thread::hardware_concurrency());
+    for (size_t threads = 1;; threads = min(threads * 2, cores))
+    {
+        ThreadPool pool(threads);
+        auto start = high_resolution_clock::now();
+        const auto intCounts = countDuplicatesParallel(ints, pool);
+        auto intUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        start = high_resolution_clock::now();
+        const auto byteCounts = countDuplicatesParallel(bytes, pool);
+        auto byteUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        vector<int> deduped = ints;
+        start = high_resolution_clock::now();
+        const size_t distinct = removeDuplicatesParallel(deduped, pool);
+        auto dedupUs = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        EXPECT_EQ(distinct, intCounts.size());
+        EXPECT_EQ(byteCounts.size(), 256);
+        cout << "  " << threads << " threads: count int " << intUs << "us, count uint8_t " << byteUs
+             << "us, stable dedup int " << dedupUs << "us" << endl;
+        if (threads == cores)
+        {
+            break;
+        }
+    }
+}
+
+TEST(OccurencesTests, UniqueVariants)
+{
+    int arr[] = {1, 2, 3, 4, 1, 2, 3, 1, 2, 1};
+    EXPECT_EQ(unique(arr, 10), vector<int>({1, 2, 3, 4}));
+    EXPECT_EQ(unique(nullptr, 10), vector<int>());
+    EXPECT_EQ(unique(vector<int>()), vector<int>());
+    EXPECT_EQ(uniqueUnordered(arr, 10), vector<int>({1, 2, 3, 4}));
+
+    mt19937 engine(45);
+    for (size_t n : {0, 1, 2, 100, 5000, 100000})
+    {
+        vector<int> values(n);
+        for (auto &value : values)
+        {
+            value = (int)engine() % 20000 - 10000;
+        }
+        if (n > 2)
+        {
+            values[0] = numeric_limits<int>::min();
+            values[1] = numeric_limits<int>::max();
+        }
+        const set<int> tree = uniqueWithSet(values.data(), (int)n);
+        const vector<int> expected(tree.begin(), tree.end());
+        EXPECT_EQ(uniqueSorted(values.data(), n), expected);
+        EXPECT_EQ(uniqueRadix(values.data(), n), expected);
+        EXPECT_EQ(unique(values), expected);
+        vector<int> unordered = uniqueUnordered(values.data(), n);
+        EXPECT_EQ(unordered.size(), expected.size());
+        sort(unordered.begin(), unordered.end());
+        EXPECT_EQ(unordered, expected);
+    }
+
+    // HyperLogLog within a few standard errors, and mergeable
+    for (size_t distinct : {0, 10, 1000, 100000, 1000000})
+    {
+        HyperLogLog all, firstHalf, secondHalf;
+        for (size_t i = 0; i < distinct; ++i)
+        {
+            all.add(i);
+            all.add(i); // repeats do not count
+            (i % 2 ? firstHalf : secondHalf).add(i);
+        }
+        firstHalf.merge(secondHalf);
+        const double tolerance = max(2.0, distinct * 4 * 1.04 / sqrt(1 << 14));
+        EXPECT_NEAR(all.estimate(), (double)distinct, tolerance);
+        EXPECT_DOUBLE_EQ(firstHalf.estimate(), all.estimate());
+    }
+}
+
+// Benchmark: distinct values of 4M ints with about 1M distinct, std::set vs the vector variants
+TEST(OccurencesTests, UniqueBenchmark)
+{
+    using namespace std::chrono;
+    const size_t n = 1 << 22;
+    mt19937 engine(46);
+    vector<int> values(n);
+    for (auto &value : values)
+    {
+        value = (int)(engine() % (1 << 20));
+    }
+
+    auto time = [&](auto &&fn)
+    {
+        auto start = high_resolution_clock::now();
+        const size_t distinct = fn();
+        auto us = duration_cast<microseconds>(high_resolution_clock::now() - start).count();
+        return make_pair(us, distinct);
+    };
+    auto tree = time([&]
+                     { return uniqueWithSet(values.data(), (int)n).size(); });
+    auto sorted = time([&]
+                       { return uniqueSorted(values.data(), n).size(); });
+    auto radix = time([&]
+                      { return uniqueRadix(values.data(), n).size(); });
+    auto hashed = time([&]
+                       { return uniqueUnordered(values.data(), n).size(); });
+    auto approximate = time([&]
+                            {
+        HyperLogLog hll;
+        for (int value : values)
+        {
+            hll.add(value);
+        }
+        return (size_t)hll.estimate(); });
+    EXPECT_EQ(sorted.second, tree.second);
+    EXPECT_EQ(radix.second, tree.second);
+    EXPECT_EQ(hashed.second, tree.second);
+    EXPECT_NEAR((double)approximate.second, (double)tree.second, tree.second * 0.05);
+
+    cout << "Run time (" << n << " ints, " << tree.second << " distinct): std::set " << tree.first << "us, sort+unique "
+         << sorted.first << "us, radix " << radix.first << "us, hash " << hashed.first << "us, HyperLogLog "
+         << approximate.first << "us (estimate " << approximate.second << ")" << endl;
+}
+
 int main(int argc, char **argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -6,11 +6,23 @@
  */
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <random>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 #include <boost/archive/binary_oarchive.hpp>
 #include <boost/archive/binary_iarchive.hpp>
 #include <nlohmann/json.hpp>
 
+#include "file_reader.h"
+#include "flat_record.h"
+#include "json_scanner.h"
+
 namespace
 {
     // Class representing a person with name, age, and email attributes
@@ -18,8 +30,8 @@ namespace
     {
     public:
         Person() = default;
-        Person(const std::string &name, int age, const std::string &email)
-            : name(name), age(age), email(email) {}
+        Person(std::string name, int age, std::string email)
+            : name(std::move(name)), age(age), email(std::move(email)) {}
 
         const std::string &getName() const { return name; }
         int getAge() const { return age; }
@@ -45,6 +57,14 @@ namespace
         }
     };
 
+    // Person fields in declaration order, used as field indices by the flat and JSON fast paths
+    enum PersonField : size_t
+    {
+        kName,
+        kAge,
+        kEmail
+    };
+
     // JSON Serialization and Deserialization Functions
     std::string serializeToJson(const Person &person)
     {
@@ -55,12 +75,123 @@ namespace
         return jsonPerson.dump();
     }
 
-    Person deserializeFromJson(const std::string &jsonStr)
+    // DOM-based parse: the reference behaviour, and the fallback for whatever the fast path declines
+    Person deserializeFromJsonDom(std::string_view jsonStr)
     {
         nlohmann::json jsonPerson = nlohmann::json::parse(jsonStr);
         return Person(jsonPerson["name"], jsonPerson["age"], jsonPerson["email"]);
     }
 
+    constexpr JsonKeyDispatch<3> kPersonKeys(std::array<std::string_view, 3>{"name", "age", "email"});
+    static_assert(kPersonKeys.valid(), "Person keys collide in the dispatch table");
+
+    /**
+     * Parse one {"name": .., "age": .., "email": ..} object at cursor straight into person, with
+     * no DOM. Keys may come in any order (the last duplicate wins), are decoded before dispatch so
+     * escaped keys match as they do in nlohmann, and extra string-valued keys are skipped. Returns
+     * false for anything else, including input that is valid JSON but outside this shape
+     * (non-string extra values, ages that are not plain ints): callers then reparse with
+     * nlohmann, so results and errors match deserializeFromJsonDom.
+     */
+    bool parsePersonJson(JsonCursor &cursor, Person &person)
+    {
+        std::string name, email, skipped, keyScratch;
+        int age = 0;
+        unsigned seen = 0;
+        if (!cursor.consume('{'))
+        {
+            return false;
+        }
+        do
+        {
+            std::string_view key, raw;
+            if (!cursor.rawString(raw) || !decodeJsonString(raw, keyScratch, key) || !cursor.consume(':'))
+            {
+                return false;
+            }
+            const int field = kPersonKeys.find(key);
+            bool parsed;
+            switch (field)
+            {
+            case kName:
+                parsed = cursor.rawString(raw) && decodeJsonString(raw, name);
+                break;
+            case kAge:
+                parsed = cursor.scalar(raw) && parseJsonInt(raw, age);
+                break;
+            case kEmail:
+                parsed = cursor.rawString(raw) && decodeJsonString(raw, email);
+                break;
+            default:
+                parsed = cursor.rawString(raw) && decodeJsonString(raw, skipped);
+                break;
+            }
+            if (!parsed)
+            {
+                return false;
+            }
+            seen |= field >= 0 ? 1u << field : 0;
+        } while (cursor.consume(','));
+        if (!cursor.consume('}') || seen != 0b111)
+        {
+            return false;
+        }
+        person = Person(std::move(name), age, std::move(email));
+        return true;
+    }
+
+    Person deserializeFromJson(const std::string &jsonStr)
+    {
+        thread_local JsonIndex index; // reused, so its token buffer is allocated once per thread
+        if (index.build(jsonStr))
+        {
+            JsonCursor cursor(jsonStr, index.positions());
+            Person person;
+            if (parsePersonJson(cursor, person) && cursor.atEnd())
+            {
+                return person;
+            }
+        }
+        return deserializeFromJsonDom(jsonStr);
+    }
+
+    /**
+     * Parse newline-delimited JSON, one Person object per line. The whole text is indexed in one
+     * pass and records are read off the index; a record the fast path declines, or one that does
+     * not sit on a line of its own, is reparsed from its line with nlohmann, which throws for
+     * lines that really are malformed.
+     */
+    std::vector<Person> deserializeFromNdjson(std::string_view text)
+    {
+        std::vector<Person> people;
+        JsonIndex index;
+        const bool indexed = index.build(text);
+        JsonCursor cursor(text, index.positions());
+        while (!cursor.atEnd())
+        {
+            const size_t start = cursor.position();
+            Person person;
+            if (indexed && parsePersonJson(cursor, person))
+            {
+                // The record must not span lines, and the next token must start on a later line.
+                // Strings cannot hold a raw newline, so any '\n' in between is a line break.
+                const size_t next = cursor.position();
+                const size_t end = text.find_last_not_of(" \t\r\n", next - 1) + 1;
+                const size_t newline = text.find('\n', start);
+                if (newline >= end && (next == text.size() || newline < next))
+                {
+                    people.push_back(std::move(person));
+                    continue;
+                }
+            }
+            const size_t lineStart = start == 0 ? 0 : text.rfind('\n', start - 1) + 1; // npos + 1 == 0
+            const size_t lineEnd = std::min(text.find('\n', start), text.size());
+            people.push_back(deserializeFromJsonDom(text.substr(lineStart, lineEnd - lineStart)));
+            cursor.seek(lineEnd);
+        }
+        return people;
+    }
+
     // Binary Serialization and Deserialization Functions
     std::string serializeToBinary(const Person &person)
     {
@@ -79,6 +210,58 @@ namespace
         return deserializedPerson;
     }
 
+    // Flat binary format: fixed slots plus a string table, read in place (see flat_record.h)
+    using PersonSchema = FlatSchema<FlatType::String, FlatType::Int32, FlatType::String>;
+
+    // Append person as one flat record, so many records can share a reused buffer
+    void appendToFlat(const Person &person, std::string &out)
+    {
+        FlatBuilder<PersonSchema>(out)
+            .set<kName>(person.getName())
+            .set<kAge>(person.getAge())
+            .set<kEmail>(person.getEmail())
+            .finish();
+    }
+
+    std::string serializeToFlat(const Person &person)
+    {
+        std::string out;
+        appendToFlat(person, out);
+        return out;
+    }
+
+    // Zero-copy accessors over a flat record; valid while the underlying buffer is
+    class PersonView
+    {
+    public:
+        explicit PersonView(FlatView<PersonSchema> view) : view(view) {}
+        PersonView(const char *data, size_t size) : view(data, size) {}
+
+        bool ok() const { return view.ok(); }
+        std::string_view getName() const { return view.get<kName>(); }
+        int getAge() const { return view.get<kAge>(); }
+        std::string_view getEmail() const { return view.get<kEmail>(); }
+
+        // Copy out into an owning Person. Throws std::runtime_error if the record is malformed.
+        Person toPerson() const
+        {
+            if (!ok())
+            {
+                throw std::runtime_error("malformed flat Person record");
+            }
+            return Person(std::string(getName()), getAge(), std::string(getEmail()));
+        }
+
+    private:
+        FlatView<PersonSchema> view;
+    };
+
+    // Throws std::runtime_error on a malformed record, as the boost and JSON readers throw on theirs
+    Person deserializeFromFlat(const std::string &flatData)
+    {
+        return PersonView(flatData.data(), flatData.size()).toPerson();
+    }
+
     // Tests
     TEST(SerializationTest, JSONSerialization)
     {
@@ -95,6 +278,405 @@ namespace
         Person binaryDeserializedPerson = deserializeFromBinary(binarySerializedData);
         ASSERT_EQ(person, binaryDeserializedPerson);
     }
+
+    TEST(SerializationTest, FlatSerialization)
+    {
+        Person person("Bob", 41, "bob@example.com");
+        std::string flatSerializedData = serializeToFlat(person);
+        ASSERT_EQ(person, deserializeFromFlat(flatSerializedData));
+        // 4 byte header, 8 + 4 + 8 bytes of slots, then the two strings
+        EXPECT_EQ(flatSerializedData.size(), 24u + 3 + 15);
+
+        PersonView view(flatSerializedData.data(), flatSerializedData.size());
+        ASSERT_TRUE(view.ok());
+        EXPECT_EQ(view.getName(), "Bob");
+        EXPECT_EQ(view.getAge(), 41);
+        EXPECT_EQ(view.getEmail(), "bob@example.com");
+        // Accessors point into the buffer rather than copying
+        EXPECT_GE(view.getName().data(), flatSerializedData.data());
+        EXPECT_LT(view.getName().data(), flatSerializedData.data() + flatSerializedData.size());
+
+        Person empty("", 0, "");
+        EXPECT_EQ(empty, deserializeFromFlat(serializeToFlat(empty)));
+    }
+
+    TEST(SerializationTest, FlatSerializationRejectsMalformed)
+    {
+        std::string data = serializeToFlat(Person("Carol", 35, "carol@example.com"));
+        EXPECT_FALSE(PersonView(data.data(), data.size() - 1).ok()); // truncated
+        EXPECT_FALSE(PersonView(data.data(), 10).ok());              // shorter than the slots
+
+        std::string badOffset = data;
+        const uint32_t outside = static_cast<uint32_t>(data.size());
+        std::memcpy(&badOffset[PersonSchema::kOffsets[kEmail]], &outside, sizeof(outside));
+        EXPECT_FALSE(PersonView(badOffset.data(), badOffset.size()).ok());
+
+        std::string badLength = data;
+        const uint32_t huge = 0xFFFFFFF0u;
+        std::memcpy(&badLength[PersonSchema::kOffsets[kName] + 4], &huge, sizeof(huge));
+        EXPECT_FALSE(PersonView(badLength.data(), badLength.size()).ok());
+
+        EXPECT_THROW(deserializeFromFlat("xy"), std::runtime_error);
+        EXPECT_THROW(deserializeFromFlat(badOffset), std::runtime_error);
+        EXPECT_THROW(deserializeFromFlat(data.substr(0, data.size() - 1)), std::runtime_error);
+    }
+
+    std::vector<Person> makePeople(size_t count)
+    {
+        std::vector<Person> people;
+        people.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const std::string name = "person" + std::to_string(i);
+            people.emplace_back(name, static_cast<int>(18 + i % 80), name + "@example.com");
+        }
+        return people;
+    }
+
+    // Records appended to one file are read back through a read-only mapping, without a parse
+    TEST(SerializationTest, FlatSerializationMappedFile)
+    {
+        const std::vector<Person> people = makePeople(1000);
+        std::string buffer;
+        for (const Person &person : people)
+        {
+            appendToFlat(person, buffer);
+        }
+        const std::string path = testing::TempDir() + "people.flat";
+        std::ofstream(path, std::ios::binary).write(buffer.data(), buffer.size());
+
+        MappedFile file(path);
+        ASSERT_TRUE(file.ok());
+        FlatStream<PersonSchema> stream(file.data(), file.size());
+        size_t index = 0;
+        for (FlatView<PersonSchema> record = stream.next(); record.ok(); record = stream.next())
+        {
+            ASSERT_LT(index, people.size());
+            EXPECT_EQ(PersonView(record).toPerson(), people[index++]);
+        }
+        EXPECT_TRUE(stream.done());
+        EXPECT_EQ(index, people.size());
+        std::remove(path.c_str());
+    }
+
+    // Encode/decode throughput and encoded size of boost binary, JSON and flat records.
+    // SERIALIZATION_BENCH_RECORDS overrides the record count.
+    TEST(SerializationTest, SerializationBenchmark)
+    {
+        using namespace std::chrono;
+        const char *records = std::getenv("SERIALIZATION_BENCH_RECORDS");
+        const std::vector<Person> people = makePeople(records ? std::strtoul(records, nullptr, 10) : 20000);
+
+        auto report = [&](const char *format, double encodeSeconds, double decodeSeconds, size_t bytes)
+        {
+            std::cout << "Run time (" << format << ", " << people.size() << " records): encode "
+                      << static_cast<uint64_t>(people.size() / encodeSeconds) << " records/s, decode "
+                      << static_cast<uint64_t>(people.size() / decodeSeconds) << " records/s, "
+                      << static_cast<double>(bytes) / people.size() << " bytes/record" << std::endl;
+        };
+        auto seconds = [](auto start)
+        { return duration<double>(steady_clock::now() - start).count(); };
+
+        {
+            std::vector<std::string> encoded;
+            encoded.reserve(people.size());
+            auto start = steady_clock::now();
+            for (const Person &person : people)
+            {
+                encoded.push_back(serializeToBinary(person));
+            }
+            const double encodeSeconds = seconds(start);
+            size_t bytes = 0;
+            start = steady_clock::now();
+            for (size_t i = 0; i < encoded.size(); ++i)
+            {
+                bytes += encoded[i].size();
+                ASSERT_EQ(deserializeFromBinary(encoded[i]).getAge(), people[i].getAge());
+            }
+            report("boost binary", encodeSeconds, seconds(start), bytes);
+        }
+        {
+            std::vector<std::string> encoded;
+            encoded.reserve(people.size());
+            auto start = steady_clock::now();
+            for (const Person &person : people)
+            {
+                encoded.push_back(serializeToJson(person));
+            }
+            const double encodeSeconds = seconds(start);
+            size_t bytes = 0;
+            start = steady_clock::now();
+            for (size_t i = 0; i < encoded.size(); ++i)
+            {
+                bytes += encoded[i].size();
+                ASSERT_EQ(deserializeFromJsonDom(encoded[i]).getAge(), people[i].getAge());
+            }
+            report("nlohmann json", encodeSeconds, seconds(start), bytes);
+        }
+        {
+            std::string buffer;
+            auto start = steady_clock::now();
+            for (const Person &person : people)
+            {
+                appendToFlat(person, buffer);
+            }
+            const double encodeSeconds = seconds(start);
+            // Views only: what a reader that uses the fields in place pays
+            start = steady_clock::now();
+            FlatStream<PersonSchema> stream(buffer.data(), buffer.size());
+            size_t i = 0, checksum = 0;
+            for (FlatView<PersonSchema> record = stream.next(); record.ok(); record = stream.next(), ++i)
+            {
+                PersonView person(record);
+                checksum += person.getName().size() + person.getEmail().size();
+                ASSERT_EQ(person.getAge(), people[i].getAge());
+            }
+            const double viewSeconds = seconds(start);
+            ASSERT_EQ(i, people.size());
+            ASSERT_GT(checksum, 0u);
+            report("flat, views", encodeSeconds, viewSeconds, buffer.size());
+
+            // Copying into Person, the like-for-like comparison with the two above
+            start = steady_clock::now();
+            FlatStream<PersonSchema> copies(buffer.data(), buffer.size());
+            i = 0;
+            for (FlatView<PersonSchema> record = copies.next(); record.ok(); record = copies.next(), ++i)
+            {
+                ASSERT_EQ(PersonView(record).toPerson().getAge(), people[i].getAge());
+            }
+            report("flat, copied", encodeSeconds, seconds(start), buffer.size());
+        }
+    }
+
+    // Scalar tokenizer with the same rules as JsonIndex, one byte at a time
+    bool referenceTokens(std::string_view text, std::vector<uint32_t> &tokens)
+    {
+        bool inString = false, escapedNext = false, prevScalar = false, control = false;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            const char c = text[i];
+            const bool escaped = escapedNext;
+            escapedNext = c == '\\' && !escaped;
+            if (inString)
+            {
+                control |= static_cast<unsigned char>(c) < 0x20;
+                if (c == '"' && !escaped)
+                {
+                    inString = false;
+                    tokens.push_back(i);
+                }
+                prevScalar = false;
+            }
+            else if (c == '"')
+            {
+                if (!escaped)
+                {
+                    inString = true;
+                    tokens.push_back(i);
+                }
+                prevScalar = false;
+            }
+            else if (std::strchr("{}[]:,", c) && c != 0)
+            {
+                tokens.push_back(i);
+                prevScalar = false;
+            }
+            else if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            {
+                prevScalar = false;
+            }
+            else
+            {
+                if (!prevScalar)
+                {
+                    tokens.push_back(i);
+                }
+                prevScalar = true;
+            }
+        }
+        return !inString && !control;
+    }
+
+    TEST(SerializationTest, JsonIndexMatchesScalarTokenizer)
+    {
+        // Heavy on quotes and backslashes so escape runs cross the 64-byte block boundaries
+        const char alphabet[] = {'"', '\\', '\\', 'a', '1', ' ', '\n', '{', '}', ':', ',', '['};
+        std::mt19937 random(42);
+        JsonIndex index;
+        for (int round = 0; round < 5000; ++round)
+        {
+            std::string text(random() % 300, ' ');
+            for (char &c : text)
+            {
+                c = alphabet[random() % sizeof(alphabet)];
+            }
+            std::vector<uint32_t> expected;
+            const bool expectedOk = referenceTokens(text, expected);
+            ASSERT_EQ(index.build(text), expectedOk) << text;
+            ASSERT_EQ(index.positions(), expected) << text;
+        }
+    }
+
+    // Parse with the fast path only; nullopt when it declines
+    std::optional<Person> parseFast(const std::string &json)
+    {
+        JsonIndex index;
+        Person person;
+        if (!index.build(json))
+        {
+            return std::nullopt;
+        }
+        JsonCursor cursor(json, index.positions());
+        if (!parsePersonJson(cursor, person) || !cursor.atEnd())
+        {
+            return std::nullopt;
+        }
+        return person;
+    }
+
+    TEST(SerializationTest, JsonFastPath)
+    {
+        for (const Person &person : {Person("John", 25, "john@example.com"),
+                                     Person("", -7, ""),
+                                     Person("Quote \" and \\ backslash", 2147483647, "tab\there\nnewline"),
+                                     Person("Zo\u00eb \u6f22\u5b57 \U0001F600", 0, "\x01\x1f control")})
+        {
+            const std::optional<Person> parsed = parseFast(serializeToJson(person));
+            ASSERT_TRUE(parsed.has_value()) << serializeToJson(person);
+            EXPECT_EQ(*parsed, person);
+            EXPECT_EQ(deserializeFromJson(serializeToJson(person)), person);
+        }
+
+        const auto expectFast = [](const std::string &json, const Person &expected)
+        {
+            const std::optional<Person> parsed = parseFast(json);
+            ASSERT_TRUE(parsed.has_value()) << json;
+            EXPECT_EQ(*parsed, expected) << json;
+        };
+        expectFast(" {\n \"email\" : \"e@x\" ,\"age\":\t30 , \"name\":\"N\"} ", Person("N", 30, "e@x"));
+        expectFast(R"({"name":"A","age":1,"email":"a","nick":"extra","name":"B"})", Person("B", 1, "a"));
+        expectFast(R"({"name":"\ud83d\ude00\/","age":-0,"email":"\u0041"})", Person("\U0001F600/", 0, "A"));
+    }
+
+    // Whatever the input, deserializeFromJson must agree with the DOM parse, errors included
+    TEST(SerializationTest, JsonFastPathMatchesDom)
+    {
+        const std::vector<std::string> inputs = {
+            R"({"name":"A","age":1,"email":"a"})",
+            R"({"name":"A","age":1.0,"email":"a"})",             // declined: float age
+            R"({"name":"A","age":1,"email":"a","tags":[1,2]})",  // declined: non-string extra value
+            R"({"n\u0061me":"A","name":"B","age":1,"email":"a"})", // escaped key, decoded before dispatch
+            "{\"\xff\":\"v\",\"name\":\"A\",\"age\":1,\"email\":\"a\"}",   // invalid UTF-8 in an unknown key
+            R"({"\q":"v","name":"A","age":1,"email":"a"})",
+            R"({"name":"A","age":1,"email":"a"} x)",
+            R"({"name":"A","age":01,"email":"a"})",
+            R"({"name":"A","age":1,"email":"a",})",
+            R"({"name":"A","age":1})",
+            R"({"name":"A" "age":1,"email":"a"})",
+            R"({"name":"A","age":true,"email":"a"})",
+            R"({"name":"\ud800","age":1,"email":"a"})",
+            R"({"name":"\q","age":1,"email":"a"})",
+            R"({"name":"A","age":99999999999,"email":"a"})",
+            "{\"name\":\"\xff\",\"age\":1,\"email\":\"a\"}",
+            "{\"name\":\"tab\there\",\"age\":1,\"email\":\"a\"}",
+            R"({"name":"A","age":1,"email":"a)",
+            R"([])",
+            "",
+        };
+        for (const std::string &input : inputs)
+        {
+            std::optional<Person> dom, fast;
+            try
+            {
+                dom = deserializeFromJsonDom(input);
+            }
+            catch (const nlohmann::json::exception &)
+            {
+            }
+            try
+            {
+                fast = deserializeFromJson(input);
+            }
+            catch (const nlohmann::json::exception &)
+            {
+            }
+            EXPECT_EQ(dom, fast) << input;
+        }
+        EXPECT_FALSE(parseFast(inputs[1]));
+        EXPECT_FALSE(parseFast(inputs[2]));
+        EXPECT_EQ(parseFast(inputs[3]), Person("B", 1, "a"));
+        EXPECT_FALSE(parseFast(inputs[4]));
+        EXPECT_FALSE(parseFast(inputs[5]));
+    }
+
+    TEST(SerializationTest, JsonNdjson)
+    {
+        const std::string text = "{\"name\":\"A\",\"age\":1,\"email\":\"a\"}\r\n"
+                                 "\n"
+                                 "{\"name\":\"B\",\"age\":2,\"email\":\"b\",\"tags\":[\"x\"]}\n" // reparsed by nlohmann
+                                 "  {\"name\":\"C\",\"age\":3,\"email\":\"c\"}";
+        const std::vector<Person> expected = {Person("A", 1, "a"), Person("B", 2, "b"), Person("C", 3, "c")};
+        EXPECT_EQ(deserializeFromNdjson(text), expected);
+        EXPECT_TRUE(deserializeFromNdjson("").empty());
+        EXPECT_THROW(deserializeFromNdjson(text + "\n{\"name\":\"D\",\"age\":}\n"), nlohmann::json::exception);
+        // Records must be one per line, as the line-by-line DOM parse requires
+        const std::string record = "{\"name\":\"D\",\"age\":4,\"email\":\"d\"}";
+        EXPECT_THROW(deserializeFromNdjson(record + " " + record), nlohmann::json::exception);
+        EXPECT_THROW(deserializeFromNdjson(record + "\n" + record + record + "\n"), nlohmann::json::exception);
+        EXPECT_THROW(deserializeFromNdjson("{\"name\":\"D\",\n\"age\":4,\"email\":\"d\"}"), nlohmann::json::exception);
+        EXPECT_EQ(deserializeFromNdjson(record + " \r\n\n" + record + "\n").size(), 2u);
+    }
+
+    // NDJSON ingest: nlohmann DOM per line against the indexed fast path over a mapped file.
+    // SERIALIZATION_NDJSON_RECORDS=1000000 gives the full-size run.
+    TEST(SerializationTest, JsonNdjsonBenchmark)
+    {
+        using namespace std::chrono;
+        const char *records = std::getenv("SERIALIZATION_NDJSON_RECORDS");
+        const std::vector<Person> people = makePeople(records ? std::strtoul(records, nullptr, 10) : 20000);
+        const std::string path = testing::TempDir() + "people.ndjson";
+        {
+            std::ofstream out(path, std::ios::binary);
+            for (const Person &person : people)
+            {
+                out << serializeToJson(person) << '\n';
+            }
+        }
+        MappedFile file(path);
+        ASSERT_TRUE(file.ok());
+        const std::string_view text(file.data(), file.size());
+        const double mebibytes = text.size() / (1024.0 * 1024.0);
+        auto report = [&](const char *parser, steady_clock::time_point start)
+        {
+            const double seconds = duration<double>(steady_clock::now() - start).count();
+            std::cout << "Run time (" << parser << ", " << people.size() << " records, " << mebibytes << " MiB): "
+                      << static_cast<uint64_t>(people.size() / seconds) << " records/s, "
+                      << mebibytes / seconds << " MiB/s" << std::endl;
+        };
+
+        auto start = steady_clock::now();
+        std::vector<Person> dom;
+        dom.reserve(people.size());
+        for (size_t begin = 0, end; begin < text.size(); begin = end + 1)
+        {
+            end = std::min(text.find('\n', begin), text.size());
+            dom.push_back(deserializeFromJsonDom(text.substr(begin, end - begin)));
+        }
+        report("nlohmann dom", start);
+
+        start = steady_clock::now();
+        JsonIndex index;
+        ASSERT_TRUE(index.build(text));
+        report("stage one index only", start);
+
+        start = steady_clock::now();
+        const std::vector<Person> fast = deserializeFromNdjson(text);
+        report("indexed fast path", start);
+
+        EXPECT_EQ(dom, people);
+        EXPECT_EQ(fast, people);
+        std::remove(path.c_str());
+    }
 }
 
 // Main function to run the tests
@@ -0,0 +1,135 @@
+/*
+ * Author: Peter Arandorenko
+ * Date: January 26, 2024
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads fed from a single task queue. Threads are started once and
+ * reused, so submitting work costs a queue push rather than a thread creation.
+ */
+class ThreadPool
+{
+public:
+    // Defaults to one worker per hardware thread (at least one).
+    explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency())
+    {
+        threadCount = std::max<size_t>(1, threadCount);
+        workers.reserve(threadCount);
+        for (size_t i = 0; i < threadCount; ++i)
+        {
+            workers.emplace_back([this]
+                                 { run(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Finishes queued tasks, then joins the workers.
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    // Queue task and return a future for its result. Exceptions propagate through the future.
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F &&task)
+    {
+        using Result = std::invoke_result_t<F>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace([packaged]
+                          { (*packaged)(); });
+        }
+        ready.notify_one();
+        return result;
+    }
+
+    /**
+     * Split [0, count) into one contiguous chunk per worker and call fn(begin, end, chunk) for
+     * each, blocking until all chunks are done. Chunk indices are dense, so callers can keep
+     * per-chunk state in a vector of size chunks(count). If chunks throw, the first one's
+     * exception is rethrown once every chunk has finished.
+     */
+    template <typename F>
+    void parallelFor(size_t count, F &&fn)
+    {
+        const size_t chunkCount = chunks(count);
+        std::vector<std::future<void>> pending;
+        pending.reserve(chunkCount);
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            const size_t begin = count * chunk / chunkCount;
+            const size_t end = count * (chunk + 1) / chunkCount;
+            pending.push_back(submit([&fn, begin, end, chunk]
+                                     { fn(begin, end, chunk); }));
+        }
+        // Every task refers to fn, so all of them must finish before an exception leaves this frame
+        for (auto &future : pending)
+        {
+            future.wait();
+        }
+        for (auto &future : pending)
+        {
+            future.get(); // rethrows the first failed chunk's exception
+        }
+    }
+
+    // Number of chunks parallelFor uses for count items.
+    size_t chunks(size_t count) const { return std::max<size_t>(1, std::min(count, workers.size())); }
+
+    size_t size() const { return workers.size(); }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this]
+                           { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                {
+                    return; // stopping and drained
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_H